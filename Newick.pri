@@ -1,13 +1,41 @@
 INCLUDEPATH += ../Newick
 
 SOURCES += \
+    $$PWD/compactnewick.cpp \
+    $$PWD/dualnumber.cpp \
     $$PWD/newick.cpp \
-    $$PWD/newickcpp98.cpp
+    $$PWD/newickcorpus.cpp \
+    $$PWD/newickcpp98.cpp \
+    $$PWD/newickhash.cpp \
+    $$PWD/newickindex.cpp \
+    $$PWD/newicklanes.cpp \
+    $$PWD/newickparallel.cpp \
+    $$PWD/newickprobabilityplan.cpp \
+    $$PWD/newickrationalfunction.cpp \
+    $$PWD/newickscanner.cpp \
+    $$PWD/persistentnewick.cpp \
+    $$PWD/smallnewick.cpp \
+    $$PWD/succinctnewick.cpp \
+    $$PWD/validatednewick.cpp
 
 HEADERS  += \
+    $$PWD/compactnewick.h \
+    $$PWD/dualnumber.h \
     $$PWD/newick.h \
+    $$PWD/newickcorpus.h \
     $$PWD/newickcpp98.h \
-    $$PWD/newickstorage.h
+    $$PWD/newickhash.h \
+    $$PWD/newickindex.h \
+    $$PWD/newicklanes.h \
+    $$PWD/newickparallel.h \
+    $$PWD/newickprobabilityplan.h \
+    $$PWD/newickrationalfunction.h \
+    $$PWD/newickscanner.h \
+    $$PWD/newickstorage.h \
+    $$PWD/persistentnewick.h \
+    $$PWD/smallnewick.h \
+    $$PWD/succinctnewick.h \
+    $$PWD/validatednewick.h
 
 
 
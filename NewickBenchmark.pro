@@ -0,0 +1,24 @@
+CONFIG += c++17
+QMAKE_CXXFLAGS += -std=c++17
+
+QMAKE_CXXFLAGS += -Wall -Wextra -Werror
+
+CONFIG   += console release
+CONFIG   -= app_bundle
+QT       -= core gui
+TEMPLATE = app
+
+# Benchmarks are only meaningful in release mode
+DEFINES += NDEBUG
+QMAKE_CXXFLAGS += -O3
+
+include(../RibiClasses/CppFuzzy_equal_to/CppFuzzy_equal_to.pri)
+
+include(../RibiLibraries/BigInteger.pri)
+
+include(Newick.pri)
+
+SOURCES += newick_benchmark.cpp
+
+# Boost.IOStreams, for memory-mapped files
+LIBS += -lboost_iostreams -lpthread
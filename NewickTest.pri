@@ -1,3 +1,17 @@
 SOURCES += \
+    $$PWD/compactnewick_test.cpp \
+    $$PWD/dualnumber_test.cpp \
     $$PWD/newick_test.cpp \
-    $$PWD/newickcpp98_test.cpp
+    $$PWD/newickcorpus_test.cpp \
+    $$PWD/newickcpp98_test.cpp \
+    $$PWD/newickhash_test.cpp \
+    $$PWD/newickindex_test.cpp \
+    $$PWD/newicklanes_test.cpp \
+    $$PWD/newickparallel_test.cpp \
+    $$PWD/newickprobabilityplan_test.cpp \
+    $$PWD/newickrationalfunction_test.cpp \
+    $$PWD/newickscanner_test.cpp \
+    $$PWD/persistentnewick_test.cpp \
+    $$PWD/smallnewick_test.cpp \
+    $$PWD/succinctnewick_test.cpp \
+    $$PWD/validatednewick_test.cpp
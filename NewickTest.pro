@@ -52,6 +52,9 @@ LIBS += -lboost_unit_test_framework
 QMAKE_CXXFLAGS += -fprofile-arcs -ftest-coverage
 LIBS += -lgcov
 
+# Boost.IOStreams, for memory-mapped files
+LIBS += -lboost_iostreams -lpthread
+
 # Boost.Graph
 LIBS += \
   -lboost_date_time \
@@ -0,0 +1,111 @@
+#include "compactnewick.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "newick.h"
+
+namespace {
+
+///The bit of a byte that denotes that the next byte belongs to the same element
+const unsigned char continuation_bit = 0x80;
+
+///Get the code of a Newick element, which is zero for a bracket open,
+///one for a bracket close, and the frequency plus one for a frequency
+unsigned int GetCompactNewickCode(const int x) noexcept
+{
+  if (x == ribi::newick::bracket_open) return 0;
+  if (x == ribi::newick::bracket_close) return 1;
+  assert(x > 0 && "A Newick must consist of brackets and frequencies only");
+  return static_cast<unsigned int>(x) + 1;
+}
+
+///Get the Newick element from its code
+int GetCompactNewickElement(const unsigned int code) noexcept
+{
+  if (code == 0) return ribi::newick::bracket_open;
+  if (code == 1) return ribi::newick::bracket_close;
+  return static_cast<int>(code - 1);
+}
+
+} //~namespace
+
+ribi::newick::CompactNewick::CompactNewick(const std::vector<int>& v)
+  : m_buffer{}
+{
+  m_buffer.reserve(v.size());
+  for (const int x: v)
+  {
+    unsigned int code = GetCompactNewickCode(x);
+    while (code >= continuation_bit)
+    {
+      m_buffer.push_back(static_cast<char>((code & 0x7F) | continuation_bit));
+      code >>= 7;
+    }
+    m_buffer.push_back(static_cast<char>(code));
+  }
+  //Only keep the bytes needed, if these do not fit in the std::string itself
+  m_buffer.shrink_to_fit();
+}
+
+std::size_t ribi::newick::CompactNewick::GetHeapMemoryUse() const noexcept
+{
+  //A std::string without a heap allocation has a capacity
+  //that equals that of an empty std::string
+  return m_buffer.capacity() == std::string().capacity()
+    ? 0
+    : m_buffer.capacity() + 1;
+}
+
+int ribi::newick::CompactNewick::Size() const noexcept
+{
+  //Count the last byte of each element
+  return static_cast<int>(
+    std::count_if(
+      std::begin(m_buffer),
+      std::end(m_buffer),
+      [](const char c)
+      {
+        return (static_cast<unsigned char>(c) & continuation_bit) == 0;
+      }
+    )
+  );
+}
+
+std::vector<int> ribi::newick::CompactNewick::ToVector() const
+{
+  std::vector<int> v;
+  v.reserve(m_buffer.size());
+  unsigned int code = 0;
+  int shift = 0;
+  for (const char c: m_buffer)
+  {
+    const unsigned int byte = static_cast<unsigned char>(c);
+    code |= (byte & 0x7F) << shift;
+    if (byte & continuation_bit)
+    {
+      shift += 7;
+      continue;
+    }
+    v.push_back(GetCompactNewickElement(code));
+    code = 0;
+    shift = 0;
+  }
+  assert(shift == 0);
+  return v;
+}
+
+bool ribi::newick::operator==(const CompactNewick& lhs, const CompactNewick& rhs) noexcept
+{
+  return lhs.Peek() == rhs.Peek();
+}
+
+bool ribi::newick::operator!=(const CompactNewick& lhs, const CompactNewick& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+bool ribi::newick::operator<(const CompactNewick& lhs, const CompactNewick& rhs) noexcept
+{
+  return lhs.Peek() < rhs.Peek();
+}
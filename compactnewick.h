@@ -0,0 +1,47 @@
+#ifndef COMPACTNEWICK_H
+#define COMPACTNEWICK_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///CompactNewick stores a Newick std::vector<int> in a single buffer,
+///to be used as a key of NewickStorage or a std::map.
+///Each element is stored as a varint of 7 bits per byte, where
+///a bracket takes one byte and a frequency of at most 126 takes one byte.
+///As the buffer is a std::string, a CompactNewick of up to
+///15 bytes (e.g. '((1000,100),100)') is stored without a heap allocation.
+///Two CompactNewicks are equal if their Newicks are equal.
+///Their ordering is a strict weak ordering, but not that of their Newicks
+struct CompactNewick
+{
+  ///Encodes a Newick, which must consist of brackets and frequencies only
+  explicit CompactNewick(const std::vector<int>& v);
+
+  ///The number of bytes of the buffer on the heap, zero if none
+  std::size_t GetHeapMemoryUse() const noexcept;
+
+  ///The encoded Newick
+  const std::string& Peek() const noexcept { return m_buffer; }
+
+  ///The number of elements of the Newick, used by NewickStorage
+  int Size() const noexcept;
+
+  ///Decodes the Newick
+  std::vector<int> ToVector() const;
+
+  private:
+  std::string m_buffer;
+};
+
+bool operator==(const CompactNewick& lhs, const CompactNewick& rhs) noexcept;
+bool operator!=(const CompactNewick& lhs, const CompactNewick& rhs) noexcept;
+bool operator<(const CompactNewick& lhs, const CompactNewick& rhs) noexcept;
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // COMPACTNEWICK_H
@@ -0,0 +1,64 @@
+#include "compactnewick.h"
+
+#include <climits>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickstorage.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CompactNewick)
+{
+  std::vector<std::vector<int>> newicks;
+  for (const std::string& s: CreateValidNewicks())
+  {
+    newicks.push_back(StringToNewick(s));
+  }
+  for (const int f: { 125, 126, 127, 128, 16382, 16383, 16384, INT_MAX - 1, INT_MAX })
+  {
+    newicks.push_back({ bracket_open, f, bracket_open, 1, f, bracket_close, bracket_close });
+  }
+  std::set<CompactNewick> compact_newicks;
+  for (const std::vector<int>& v: newicks)
+  {
+    const CompactNewick n(v);
+    BOOST_CHECK(n.ToVector() == v);
+    BOOST_CHECK_EQUAL(n.Size(), static_cast<int>(v.size()));
+    BOOST_CHECK(n == CompactNewick(v));
+    compact_newicks.insert(n);
+  }
+  //Equal CompactNewicks if and only if equal Newicks
+  BOOST_CHECK_EQUAL(
+    compact_newicks.size(),
+    std::set<std::vector<int>>(newicks.begin(), newicks.end()).size()
+  );
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CompactNewick_size)
+{
+  //Brackets and small frequencies take one byte each
+  const CompactNewick n(StringToNewick("((1000,100),100)"));
+  BOOST_CHECK_EQUAL(n.Peek().size(), 8);
+  BOOST_CHECK_EQUAL(n.GetHeapMemoryUse(), 0);
+  //A frequency of at most 126 takes one byte
+  BOOST_CHECK_EQUAL(CompactNewick(StringToNewick("(126)")).Peek().size(), 3);
+  BOOST_CHECK_EQUAL(CompactNewick(StringToNewick("(127)")).Peek().size(), 4);
+  const CompactNewick m(StringToNewick(CreateRandomNewick(100, 1000)));
+  BOOST_CHECK(m.GetHeapMemoryUse() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CompactNewick_NewickStorage)
+{
+  const CompactNewick n(StringToNewick("((2,2),2)"));
+  ribi::NewickStorage<CompactNewick> storage(n);
+  BOOST_CHECK_EQUAL(storage.Find(n), 0.0);
+  storage.Store(n, 0.5);
+  BOOST_CHECK_EQUAL(storage.Find(n), 0.5);
+  const CompactNewick m(StringToNewick("((1,2),2)"));
+  BOOST_CHECK_EQUAL(storage.Find(m), 0.0);
+  BOOST_CHECK_EQUAL(storage.CountNewicks(), 1);
+}
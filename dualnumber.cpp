@@ -0,0 +1,134 @@
+#include "dualnumber.h"
+
+#include <cassert>
+
+#include "newick.h"
+
+ribi::newick::DualNumber::DualNumber() noexcept
+  : m_value{0.0},
+    m_first{0.0},
+    m_second{0.0}
+{
+
+}
+
+ribi::newick::DualNumber::DualNumber(const double value) noexcept
+  : m_value{value},
+    m_first{0.0},
+    m_second{0.0}
+{
+
+}
+
+ribi::newick::DualNumber::DualNumber(
+  const double value,
+  const double first,
+  const double second
+) noexcept
+  : m_value{value},
+    m_first{first},
+    m_second{second}
+{
+
+}
+
+ribi::newick::DualNumber ribi::newick::DualNumber::CreateVariable(const double value) noexcept
+{
+  return DualNumber(value, 1.0, 0.0);
+}
+
+ribi::newick::DualNumber& ribi::newick::DualNumber::operator+=(const DualNumber& rhs) noexcept
+{
+  m_value += rhs.m_value;
+  m_first += rhs.m_first;
+  m_second += rhs.m_second;
+  return *this;
+}
+
+ribi::newick::DualNumber ribi::newick::CalcProbabilitySimpleNewick(
+  const std::vector<int>& v,
+  const DualNumber& theta)
+{
+  assert(IsSimple(v));
+  //As CalcProbabilitySimpleNewick on a double
+  int n=0;
+  int k=0;
+  DualNumber probability(1.0);
+  for (const int ni: v)
+  {
+    if (ni <= 0) continue;
+    ++k;
+    ++n;
+    for (int p=1; p!=ni; ++p, ++n)
+    {
+      probability = probability
+        * (static_cast<double>(p) / (DualNumber(static_cast<double>(n)) + theta));
+    }
+    probability = probability / (DualNumber(static_cast<double>(n)) + theta);
+  }
+  probability = probability * (DualNumber(static_cast<double>(n)) + theta);
+  for (int i=1; i<k; ++i)
+  {
+    probability = probability * theta;
+  }
+  return probability;
+}
+
+bool ribi::newick::operator==(const DualNumber& lhs, const DualNumber& rhs) noexcept
+{
+  return lhs.GetValue() == rhs.GetValue()
+    && lhs.GetFirstDerivative() == rhs.GetFirstDerivative()
+    && lhs.GetSecondDerivative() == rhs.GetSecondDerivative();
+}
+
+bool ribi::newick::operator!=(const DualNumber& lhs, const DualNumber& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+ribi::newick::DualNumber ribi::newick::operator+(const DualNumber& lhs, const DualNumber& rhs) noexcept
+{
+  DualNumber sum(lhs);
+  sum += rhs;
+  return sum;
+}
+
+ribi::newick::DualNumber ribi::newick::operator*(const DualNumber& lhs, const DualNumber& rhs) noexcept
+{
+  //(fg)' = f'g + fg', (fg)'' = f''g + 2f'g' + fg''
+  return DualNumber(
+    lhs.GetValue() * rhs.GetValue(),
+    (lhs.GetFirstDerivative() * rhs.GetValue()) + (lhs.GetValue() * rhs.GetFirstDerivative()),
+    (lhs.GetSecondDerivative() * rhs.GetValue())
+      + (2.0 * lhs.GetFirstDerivative() * rhs.GetFirstDerivative())
+      + (lhs.GetValue() * rhs.GetSecondDerivative())
+  );
+}
+
+ribi::newick::DualNumber ribi::newick::operator*(const double lhs, const DualNumber& rhs) noexcept
+{
+  return DualNumber(
+    lhs * rhs.GetValue(),
+    lhs * rhs.GetFirstDerivative(),
+    lhs * rhs.GetSecondDerivative()
+  );
+}
+
+ribi::newick::DualNumber ribi::newick::operator/(const DualNumber& lhs, const DualNumber& rhs) noexcept
+{
+  //For q = f/g: q' = (f' - qg') / g, q'' = (f'' - 2q'g' - qg'') / g
+  assert(rhs.GetValue() != 0.0);
+  const double q = lhs.GetValue() / rhs.GetValue();
+  const double q_first = (lhs.GetFirstDerivative() - (q * rhs.GetFirstDerivative())) / rhs.GetValue();
+  const double q_second = (
+      lhs.GetSecondDerivative()
+    - (2.0 * q_first * rhs.GetFirstDerivative())
+    - (q * rhs.GetSecondDerivative())
+  ) / rhs.GetValue();
+  return DualNumber(q, q_first, q_second);
+}
+
+ribi::newick::DualNumber ribi::newick::operator/(const double lhs, const DualNumber& rhs) noexcept
+{
+  return DualNumber(lhs) / rhs;
+}
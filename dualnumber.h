@@ -0,0 +1,78 @@
+#ifndef DUALNUMBER_H
+#define DUALNUMBER_H
+
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///DualNumber is a value with its first and second derivative
+///with respect to a variable, of which each arithmetic operation
+///applies the rules of differentiation (forward-mode differentiation).
+///Used as the probability of a NewickStorage, CalculateProbability
+///calculates the probability and its derivatives with respect to theta
+///in the same calculation, when called with theta from CreateVariable:
+///
+///  NewickStorage<SmallNewick, std::map<SmallNewick,DualNumber>> storage(n);
+///  const DualNumber p = CalculateProbability(n, DualNumber::CreateVariable(theta), storage);
+///
+struct DualNumber
+{
+  ///Zero, which a NewickStorage uses for an unknown probability
+  DualNumber() noexcept;
+
+  ///A constant, of which the derivatives are zero
+  explicit DualNumber(const double value) noexcept;
+
+  DualNumber(const double value, const double first, const double second) noexcept;
+
+  ///The variable itself, of which the first derivative is one
+  static DualNumber CreateVariable(const double value) noexcept;
+
+  double GetValue() const noexcept { return m_value; }
+  double GetFirstDerivative() const noexcept { return m_first; }
+  double GetSecondDerivative() const noexcept { return m_second; }
+
+  DualNumber& operator+=(const DualNumber& rhs) noexcept;
+
+  private:
+  double m_value;
+  double m_first;
+  double m_second;
+};
+
+bool operator==(const DualNumber& lhs, const DualNumber& rhs) noexcept;
+bool operator!=(const DualNumber& lhs, const DualNumber& rhs) noexcept;
+DualNumber operator+(const DualNumber& lhs, const DualNumber& rhs) noexcept;
+DualNumber operator*(const DualNumber& lhs, const DualNumber& rhs) noexcept;
+DualNumber operator*(const double lhs, const DualNumber& rhs) noexcept;
+DualNumber operator/(const DualNumber& lhs, const DualNumber& rhs) noexcept;
+DualNumber operator/(const double lhs, const DualNumber& rhs) noexcept;
+
+///CalcProbabilitySimpleNewick calculates the probability of a simple Newick
+///and its derivatives, as CalcProbabilitySimpleNewick does for a double
+DualNumber CalcProbabilitySimpleNewick(
+  const std::vector<int>& v,
+  const DualNumber& theta);
+
+///Used by CalculateProbability, for a theta of type DualNumber.
+///The denominator is linear in theta
+template <class NewickType>
+DualNumber CalcDenominatorOf(const NewickType& n, const DualNumber& theta) noexcept
+{
+  const double d_0 = n.CalcDenominator(0.0);
+  const double slope = n.CalcDenominator(1.0) - d_0;
+  return DualNumber(d_0) + (slope * theta);
+}
+
+///Used by CalculateProbability, for a theta of type DualNumber
+template <class NewickType>
+DualNumber CalcProbabilitySimpleNewickOf(const NewickType& n, const DualNumber& theta)
+{
+  return CalcProbabilitySimpleNewick(n.ToVector(), theta);
+}
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // DUALNUMBER_H
@@ -0,0 +1,63 @@
+#include "dualnumber.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "newick.h"
+#include "newickhash.h"
+#include "newickstorage.h"
+#include "persistentnewick.h"
+#include "smallnewick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_DualNumber)
+{
+  //f(x) = x^2 / (1 + x) at x = 2: f = 4/3, f' = 8/9, f'' = 2/27
+  const DualNumber x{DualNumber::CreateVariable(2.0)};
+  const DualNumber f{(x * x) / (DualNumber(1.0) + x)};
+  BOOST_CHECK_CLOSE(f.GetValue(), 4.0 / 3.0, 0.0001);
+  BOOST_CHECK_CLOSE(f.GetFirstDerivative(), 8.0 / 9.0, 0.0001);
+  BOOST_CHECK_CLOSE(f.GetSecondDerivative(), 2.0 / 27.0, 0.0001);
+  BOOST_CHECK(DualNumber() == DualNumber(0.0));
+  BOOST_CHECK(DualNumber(1.0) != x);
+  BOOST_CHECK(DualNumber(2.0, 1.0, 0.0) == x);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CalculateProbability_DualNumber)
+{
+  //The derivatives are compared to central finite differences
+  const double h = 0.001;
+  for (const std::string s: { "(3)", "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))", "((10,2),3)" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    for (const double theta: { 0.5, 10.0 })
+    {
+      ribi::NewickStorage<SmallNewick, std::map<SmallNewick,DualNumber>> storage(n);
+      const DualNumber p{CalculateProbability(n, DualNumber::CreateVariable(theta), storage)};
+      std::vector<double> ps;
+      for (const double t: { theta - h, theta, theta + h })
+      {
+        ribi::NewickStorage<SmallNewick> double_storage(n);
+        ps.push_back(CalculateProbability(n, t, double_storage));
+      }
+      BOOST_CHECK_CLOSE(p.GetValue(), ps[1], 0.0001);
+      BOOST_CHECK_CLOSE(p.GetFirstDerivative(), (ps[2] - ps[0]) / (2.0 * h), 0.01);
+      BOOST_CHECK_CLOSE(p.GetSecondDerivative(), (ps[2] - (2.0 * ps[1]) + ps[0]) / (h * h), 0.1);
+    }
+  }
+  //Any NewickType and Map
+  const std::vector<int> v{StringToNewick("((2,1),(1,3))")};
+  ribi::NewickStorage<SmallNewick, std::map<SmallNewick,DualNumber>> storage(SmallNewick{v});
+  const DualNumber p{CalculateProbability(SmallNewick(v), DualNumber::CreateVariable(10.0), storage)};
+  ribi::NewickStorage<
+    PersistentNewick, std::unordered_map<PersistentNewick,DualNumber,NewickHash>
+  > persistent_storage(PersistentNewick{v});
+  const DualNumber q{CalculateProbability(PersistentNewick(v), DualNumber::CreateVariable(10.0), persistent_storage)};
+  BOOST_CHECK_CLOSE(q.GetValue(), p.GetValue(), 0.0001);
+  BOOST_CHECK_CLOSE(q.GetFirstDerivative(), p.GetFirstDerivative(), 0.0001);
+  BOOST_CHECK_CLOSE(q.GetSecondDerivative(), p.GetSecondDerivative(), 0.0001);
+}
@@ -7,10 +7,12 @@
 #include <deque>
 #include <iostream>
 #include <functional>
+#include <limits>
 #include <map>
 #include <numeric>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 
@@ -21,6 +23,9 @@
 #include "BigIntegerLibrary.hh"
 
 #include "newickcpp98.h"
+#include "newickindex.h"
+#include "newickscanner.h"
+#include "validatednewick.h"
 
 
 //From http://www.richelbilderbeek.nl/CppAccumulate_if.htm
@@ -41,6 +46,309 @@ const ElementType Accumulate_if(
   return init;
 }
 
+namespace {
+
+//The functions below assume that their input is a valid Newick,
+//so that they can be shared by the overloads taking a std::vector<int>,
+//which check this first, and those taking a ValidatedNewick, which do not
+
+double CalcProbabilitySimpleNewickUnchecked(
+  const std::vector<int>& v,
+  const double theta) noexcept
+{
+  const int sz = v.size();
+
+  int n=0;
+  int k=0;
+
+  double probability = 1.0;
+
+  for (int i=0; i!=sz; ++i)
+  {
+    if (v[i]>0)
+    {
+      const int ni = v[i];
+      ++k;
+      ++n;
+      for (int p=1; p!=ni; ++p, ++n)
+      {
+        probability *= (static_cast<double>(p)
+          / ( static_cast<double>(n) + theta));
+      }
+      probability /= ( static_cast<double>(n) + theta);
+    }
+  }
+  probability *= (static_cast<double>(n)+theta)
+    * std::pow(theta,static_cast<double>(k-1));
+  return probability;
+}
+
+std::vector<int> GetDepthUnchecked(const std::vector<int>& n) noexcept
+{
+  std::vector<int> v;
+  v.reserve(n.size());
+  int depth = -1;
+  for(const int& x: n)
+  {
+    if (x == ribi::newick::bracket_open) ++depth;
+    v.push_back(depth);
+    if (x == ribi::newick::bracket_close) --depth;
+  }
+  assert(n.size() == v.size());
+  return v;
+}
+
+bool IsSimpleUnchecked(const std::vector<int>& v) noexcept
+{
+  //A Newick is simple if it contains no '(' after the initial one
+  return std::count(
+    v.begin()+1,v.end(),
+    static_cast<int>(ribi::newick::bracket_open)
+  ) == 0;
+}
+
+bool IsUnaryNewickUnchecked(const std::vector<int>& v) noexcept
+{
+  return v.size() == 3
+    && v[0] == ribi::newick::bracket_open
+    && v[1] >  0
+    && v[2] == ribi::newick::bracket_close;
+}
+
+int GetLeafMaxArityUnchecked(const std::vector<int>& n) noexcept
+{
+  const int size = boost::numeric_cast<int>(n.size());
+  if (IsSimpleUnchecked(n)) return size - 2;
+
+  int max = 0;
+  for (int from = 0; from!=size; ++from)
+  {
+    if (n[from] != ribi::newick::bracket_open) continue;
+    for (int to = from+1; to!=size; ++to)
+    {
+      if (n[to] == ribi::newick::bracket_open) break;
+      if (n[to]  > 0) continue;
+      if (n[to] == ribi::newick::bracket_close)
+      {
+        assert(from < to);
+        max = std::max(max, to - from - 1);
+        break;
+      }
+    }
+  }
+  return max;
+}
+
+std::vector<int> ReplaceLeaveUnchecked(
+  const std::vector<int>& newick,
+  const int value
+)
+{
+  assert(!IsSimpleUnchecked(newick) && "There must a leaf to simplify");
+  typedef std::vector<int>::const_iterator Iterator;
+  const Iterator end = newick.end();
+  for (Iterator from = newick.begin(); from!=end; ++from)
+  {
+    if (*from != ribi::newick::bracket_open) continue;
+
+    for (Iterator to = from + 1; to!=end; ++to)
+    {
+      if (*to > 0) continue;
+      if (*to == ribi::newick::bracket_open) break;
+      if (*to == ribi::newick::bracket_close)
+      {
+        //Found
+        std::vector<int> new_newick(newick.begin(),from);
+        new_newick.push_back(value);
+        std::copy(to + 1,newick.end(),std::back_inserter(new_newick));
+        assert(ribi::newick::IsNewick(new_newick));
+        return new_newick;
+      }
+    }
+  }
+  assert(!"Should not get here"); //!OCLINT
+  throw std::logic_error("Should not get here");
+}
+
+bool IsBinaryNewickUnchecked(std::vector<int> v) noexcept
+{
+  if (IsUnaryNewickUnchecked(v)) return false;
+
+  while (1)
+  {
+    const int sz = boost::numeric_cast<int>(v.size());
+    //Only numbers?
+    if (IsSimpleUnchecked(v))
+    {
+      //Binary Newick has size 4, for example '(1,2)'
+      return sz == 4;
+    }
+    if (GetLeafMaxArityUnchecked(v) > 2) return false;
+    v = ReplaceLeaveUnchecked(v,42);
+  }
+}
+
+bool IsTrinaryNewickUnchecked(std::vector<int> v) noexcept
+{
+  if (IsUnaryNewickUnchecked(v)) return false;
+  if (IsBinaryNewickUnchecked(v)) return false;
+
+  bool trinarity_found = false;
+
+  while (1)
+  {
+    const int sz = boost::numeric_cast<int>(v.size());
+    //Only numbers?
+    if (IsSimpleUnchecked(v))
+    {
+      //Ternary Newick has size 5, for example '(1,2,3)'
+      return trinarity_found || sz == 5;
+    }
+    const int leaf_max_arity = GetLeafMaxArityUnchecked(v);
+    if (leaf_max_arity > 3) return false;
+    if (leaf_max_arity == 3) trinarity_found = true;
+
+    v = ReplaceLeaveUnchecked(v,42);
+  }
+}
+
+std::vector<std::vector<int>>
+  GetSimplerNewicksEasyUnchecked(const std::vector<int>& n) noexcept
+{
+  std::vector<std::vector<int>> newicks;
+  const int size = boost::numeric_cast<int>(n.size());
+
+  for (int i = 0; i!=size; ++i)
+  {
+    assert(i >= 0);
+    assert(i < size);
+    if (n[i] < 1) continue;
+    assert(n[i] > 0);
+    //If a frequency is above one, it is easy to create the simpler newicks
+    if (n[i] > 1)
+    {
+      std::vector<int> new_newick(n);
+      --new_newick[i];
+      newicks.push_back(new_newick);
+    }
+  }
+  return newicks;
+}
+
+///index must be the NewickIndex of n
+std::vector<std::vector<int>>
+  GetSimplerNewicksHardFromHereUnchecked(
+    const std::vector<int>& n,
+    const int i,
+    const ribi::newick::NewickIndex& index
+) noexcept
+{
+  using ribi::newick::NewickIndex;
+  assert(index.size() == n.size());
+  assert(i >= 0);
+  assert(i < static_cast<int>(n.size()));
+  assert(n[i] == 1); //Otherwise it would not be hard
+  std::vector<std::vector<int>> newicks;
+
+  //Visit the siblings of i, first those before it, then those after it
+  std::size_t j = index.GetPreviousSibling(i);
+  bool before = true;
+  while (1)
+  {
+    if (j == NewickIndex::npos)
+    {
+      if (!before) break;
+      before = false;
+      j = index.GetNextSibling(i);
+      continue;
+    }
+    assert(j != static_cast<std::size_t>(i));
+    assert(j < n.size());
+    //Only take frequencies into account, not subtrees
+    if (n[j] < 1)
+    {
+      j = before ? index.GetPreviousSibling(j) : index.GetNextSibling(j);
+      continue;
+    }
+    std::vector<int> new_newick_with_zero(n);
+    --new_newick_with_zero[i];
+    assert(new_newick_with_zero[i] == 0);
+    ++new_newick_with_zero[j];
+    //Remove brackets after possibly lonely value
+    //If there is only one or two values between
+    //the brackets, and one of these values was a
+    //1 becoming added to the other, nullify the
+    //1 and both brackets:
+    //'((1,1),2)' -> '(00102)' -> '(1,2)'
+    if (std::abs(i - static_cast<int>(j)) == 1)
+    {
+      const int index_bracket_open  = std::min(i,static_cast<int>(j)) - 1;
+      const int index_bracket_close = std::max(i,static_cast<int>(j)) + 1;
+      if ( new_newick_with_zero[index_bracket_open]  == ribi::newick::bracket_open
+        && new_newick_with_zero[index_bracket_close] == ribi::newick::bracket_close)
+      {
+        new_newick_with_zero[index_bracket_open]  = 0;
+        new_newick_with_zero[index_bracket_close] = 0;
+      }
+    }
+    //Remove decremented i and possibly nullified brackets
+    std::vector<int> new_newick;
+    std::remove_copy(
+      new_newick_with_zero.begin(),
+      new_newick_with_zero.end(),
+      std::back_inserter(new_newick),
+      0);
+    //Add brackets if these are removed
+    if (new_newick.front() != ribi::newick::bracket_open
+      || new_newick.back() != ribi::newick::bracket_close)
+    {
+      new_newick = ribi::newick::Surround(new_newick);
+    }
+    assert(ribi::newick::IsNewick(new_newick));
+    newicks.push_back(new_newick);
+    j = before ? index.GetPreviousSibling(j) : index.GetNextSibling(j);
+  }
+  return newicks;
+}
+
+std::vector<std::vector<int>>
+  GetSimplerNewicksHardUnchecked(const std::vector<int>& n) noexcept
+{
+  std::vector<std::vector<int>> newicks;
+  const int size = boost::numeric_cast<int>(n.size());
+  //Index n only if it has a frequency of one
+  if (std::find(n.begin(), n.end(), 1) == n.end()) return newicks;
+  const ribi::newick::NewickIndex index(n);
+
+  //Go through all positions
+  for (int i = 0; i!=size; ++i)
+  {
+    assert(i >= 0);
+    assert(i < size);
+    if (n[i] != 1) continue;
+    //If a frequency is one, the Newick needs to be simplified
+    assert(n[i] == 1); //Most difficult...
+    const auto v = GetSimplerNewicksHardFromHereUnchecked(n, i, index);
+    std::copy(std::begin(v), std::end(v), std::back_inserter(newicks));
+  }
+  return newicks;
+}
+
+std::vector<std::vector<int>>
+  GetSimplerNewicksUnchecked(const std::vector<int>& n) noexcept
+{
+  std::vector<std::vector<int>> newicks = GetSimplerNewicksEasyUnchecked(n);
+  const std::vector<std::vector<int>> hard_newicks = GetSimplerNewicksHardUnchecked(n);
+  std::copy(
+    std::begin(hard_newicks),
+    std::end(hard_newicks),
+    std::back_inserter(newicks)
+  );
+  return newicks;
+}
+
+} //~namespace
+
 BigInteger ribi::newick::CalcComplexity(const std::vector<int>& v)
 {
   if (v.empty()) return 0;
@@ -83,11 +391,11 @@ BigInteger ribi::newick::CalcNumOfCombinationsBinary(const std::vector<int>& v)
   std::copy_if(
     std::begin(v),std::end(v),
     std::back_inserter(positives),
-    std::bind2nd(std::greater<BigInteger>(),0)
+    [](const int i) { return i > 0; }
   );
 
   //Obtain numerator = (SUM(x))!
-  const int sum_values = Accumulate_if(v.begin(),v.end(),0,std::bind2nd(std::greater<int>(),0));
+  const int sum_values = Accumulate_if(v.begin(),v.end(),0,[](const int i) { return i > 0; });
 
   BigInteger numerator = FactorialBigInt(sum_values);
 
@@ -135,8 +443,7 @@ BigInteger ribi::newick::CalcNumOfSymmetriesBinary(std::vector<int> v)
   {
     //Count number of symmetries
     assert(!v.empty());
-    const std::size_t sz = v.size();
-    assert(sz >= 2);
+    assert(v.size() >= 2);
     n_symmetries += CountAdjacentNonZeroPositives(v);
 
     //Collect all leafs and store new leafs
@@ -176,34 +483,69 @@ double ribi::newick::CalcProbabilitySimpleNewick(
 {
   assert(newick::IsNewick(v));
   assert(IsSimple(v));
-  const int sz = v.size();
-
-  int n=0;
-  int k=0;
+  return CalcProbabilitySimpleNewickUnchecked(v, theta);
+}
 
-  double probability = 1.0;
+double ribi::newick::CalcProbabilitySimpleNewick(
+  const ValidatedNewick& v,
+  const double theta)
+{
+  assert(IsSimple(v));
+  return CalcProbabilitySimpleNewickUnchecked(v.Peek(), theta);
+}
 
-  for (int i=0; i!=sz; ++i)
+bool ribi::newick::CanonicalizeNewick(int * const begin, int * const end) noexcept
+{
+  assert(IsNewick(std::vector<int>(begin, end)));
+  //The end of the subtree or frequency that starts at i
+  const auto get_end = [](auto i)
   {
-    if (v[i]>0)
+    if (*i != bracket_open) return i + 1;
+    int depth = 0;
+    do
     {
-      const int ni = v[i];
-      ++k;
-      ++n;
-      for (int p=1; p!=ni; ++p, ++n)
+      if (*i == bracket_open) ++depth;
+      if (*i == bracket_close) --depth;
+      ++i;
+    }
+    while (depth != 0);
+    return i;
+  };
+  bool is_changed = false;
+  //Each subtree is closed after its children are closed and sorted
+  for (int * close = begin; close != end; ++close)
+  {
+    if (*close != bracket_close) continue;
+    int * open = close - 1;
+    for (int depth = 0; depth != 0 || *open != bracket_open; --open)
+    {
+      if (*open == bracket_close) ++depth;
+      if (*open == bracket_open) --depth;
+    }
+    //Insertion sort of the children, in which [open + 1, sorted_end)
+    //holds the sorted children
+    for (int * sorted_end = open + 1; sorted_end != close; )
+    {
+      int * const child_end = get_end(sorted_end);
+      int * pos = open + 1;
+      while (pos != sorted_end)
       {
-        probability *= (static_cast<double>(p)
-          / ( static_cast<double>(n) + theta));
+        int * const pos_end = get_end(pos);
+        if (std::lexicographical_compare(sorted_end, child_end, pos, pos_end)) break;
+        pos = pos_end;
       }
-      probability /= ( static_cast<double>(n) + theta);
+      if (pos != sorted_end)
+      {
+        std::rotate(pos, sorted_end, child_end);
+        is_changed = true;
+      }
+      sorted_end = child_end;
     }
   }
-  probability *= (static_cast<double>(n)+theta)
-    * std::pow(theta,static_cast<double>(k-1));
-  return probability;
+  return is_changed;
 }
 
-void ribi::newick::CheckNewickForMinimalSize(const std::string& s)
+void ribi::newick::CheckNewickForMinimalSize(const std::string_view s)
 {
   if (s.size()<3)
   {
@@ -214,7 +556,7 @@ void ribi::newick::CheckNewickForMinimalSize(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForOpeningBracket(const std::string& s)
+void ribi::newick::CheckNewickForOpeningBracket(const std::string_view s)
 {
   if (s[0]!='(')
   {
@@ -225,7 +567,7 @@ void ribi::newick::CheckNewickForOpeningBracket(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForClosingBracket(const std::string& s)
+void ribi::newick::CheckNewickForClosingBracket(const std::string_view s)
 {
   if (s[s.size()-1]!=')')
   {
@@ -236,7 +578,7 @@ void ribi::newick::CheckNewickForClosingBracket(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForMatchingBrackets(const std::string& s)
+void ribi::newick::CheckNewickForMatchingBrackets(const std::string_view s)
 {
   if (std::count(std::begin(s),std::end(s),'(')
     !=std::count(std::begin(s),std::end(s),')'))
@@ -248,16 +590,16 @@ void ribi::newick::CheckNewickForMatchingBrackets(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForZero(const std::string& s)
+void ribi::newick::CheckNewickForZero(const std::string_view s)
 {
-  if (s.find("(0")!=std::string::npos)
+  if (s.find("(0")!=std::string_view::npos)
   {
     throw std::invalid_argument(
       "A std::string Newick frequency cannot be or "
       "start with a zero (#1)"
     );
   }
-  if (s.find(",0")!=std::string::npos)
+  if (s.find(",0")!=std::string_view::npos)
   {
     throw std::invalid_argument(
       "A std::string Newick frequency cannot be or "
@@ -266,9 +608,9 @@ void ribi::newick::CheckNewickForZero(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForBracketDistance(const std::string& s)
+void ribi::newick::CheckNewickForBracketDistance(const std::string_view s)
 {
-  if (s.find("()")!=std::string::npos)
+  if (s.find("()")!=std::string_view::npos)
   {
     throw std::invalid_argument(
       "The Newick std::string cannot have "
@@ -277,9 +619,9 @@ void ribi::newick::CheckNewickForBracketDistance(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForConsecutiveCommas(const std::string& s)
+void ribi::newick::CheckNewickForConsecutiveCommas(const std::string_view s)
 {
-  if (s.find(",,") != std::string::npos)
+  if (s.find(",,") != std::string_view::npos)
   {
     throw std::invalid_argument(
       "A Newick std::string can have no consecutive comma's"
@@ -287,9 +629,9 @@ void ribi::newick::CheckNewickForConsecutiveCommas(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewickForCommaAfterBracketOpen(const std::string& s)
+void ribi::newick::CheckNewickForCommaAfterBracketOpen(const std::string_view s)
 {
-  if (s.find("(,")!=std::string::npos)
+  if (s.find("(,")!=std::string_view::npos)
   {
     throw std::invalid_argument(
       "A Newick std::string cannot have comma "
@@ -299,9 +641,9 @@ void ribi::newick::CheckNewickForCommaAfterBracketOpen(const std::string& s)
 }
 
 
-void ribi::newick::CheckNewickForCommaBeforeBracketClose(const std::string& s)
+void ribi::newick::CheckNewickForCommaBeforeBracketClose(const std::string_view s)
 {
-  if (s.find(",)")!=std::string::npos)
+  if (s.find(",)")!=std::string_view::npos)
   {
     throw std::invalid_argument(
       "A Newick std::string cannot have comma "
@@ -310,7 +652,209 @@ void ribi::newick::CheckNewickForCommaBeforeBracketClose(const std::string& s)
   }
 }
 
-void ribi::newick::CheckNewick(const std::string& s)
+namespace {
+
+///ScanNewick checks if s is a valid Newick in a single pass, and,
+///if newick is not a nullptr, meanwhile appends the Newick values to it.
+///The checks are done in the same order as CheckNewickByCuttingLeaves,
+///which also determines which error is returned if there are multiple.
+///To simulate the cutting of leaves, the innermost leaf is cut at each
+///closing bracket, using a stack of the currently open brackets
+ribi::newick::NewickError ScanNewick(
+  const std::string_view s,
+  std::vector<int> * const newick
+)
+{
+  using ribi::newick::NewickError;
+  using ribi::newick::NewickErrorCode;
+  using ribi::newick::bracket_open;
+  using ribi::newick::bracket_close;
+  const std::size_t sz = s.size();
+  if (sz < 3) return { NewickErrorCode::too_short, 0 };
+  if (s[0] != '(') return { NewickErrorCode::no_opening_bracket, 0 };
+  if (s[sz - 1] != ')') return { NewickErrorCode::no_closing_bracket, sz - 1 };
+
+  struct OpenBracket
+  {
+    std::size_t index; //Index of the opening bracket in s
+    bool has_comma;    //Is there a comma directly within these brackets?
+    std::size_t invalid; //Index of first invalid character directly within, npos if none
+  };
+  std::vector<OpenBracket> open_brackets;
+
+  const std::size_t npos = std::string_view::npos;
+  int n_open = 0;
+  int n_close = 0;
+  std::size_t first_unmatched_close = npos;
+  std::size_t bracket_zero = npos;          //'(0'
+  std::size_t comma_zero = npos;            //',0'
+  std::size_t bracket_distance = npos;      //'()'
+  std::size_t consecutive_commas = npos;    //',,'
+  std::size_t bracket_comma = npos;         //'(,'
+  std::size_t comma_bracket = npos;         //',)'
+  std::size_t value_too_large = npos;
+
+  //The first error found while cutting the leaves
+  NewickError leaf_error = { NewickErrorCode::none, 0 };
+
+  //The number of characters left after all leaves are cut
+  std::size_t n_left = 0;
+  std::size_t third_left = npos;
+
+  //Only the non-digit characters are visited one by one,
+  //the digits in between are handled as a run
+  ribi::newick::NewickStructuralScanner scanner(s);
+  std::size_t run_begin = 0;
+  for (std::size_t i = scanner.Next(); ; i = scanner.Next())
+  {
+    if (run_begin != i)
+    {
+      //The digits from run_begin to i
+      assert(run_begin > 0);
+      const char prev = s[run_begin - 1];
+      if (prev == '(' && s[run_begin] == '0' && bracket_zero == npos) bracket_zero = run_begin;
+      if (prev == ',' && s[run_begin] == '0' && comma_zero == npos) comma_zero = run_begin;
+      //The value is read also if it is not stored, as a value that
+      //does not fit in an int makes the Newick invalid for both
+      int value = 0;
+      for (std::size_t j=run_begin; j!=i; ++j)
+      {
+        const int digit = s[j] - '0';
+        if (value > (std::numeric_limits<int>::max() - digit) / 10)
+        {
+          if (value_too_large == npos) value_too_large = run_begin;
+          value = 0;
+        }
+        value = (value * 10) + digit;
+      }
+      if (newick && value != 0) newick->push_back(value);
+      if (open_brackets.empty())
+      {
+        if (n_left < 3 && n_left + (i - run_begin) >= 3) third_left = run_begin + (2 - n_left);
+        n_left += i - run_begin;
+      }
+    }
+    if (i == sz) break;
+    run_begin = i + 1;
+
+    const char c = s[i];
+    const char prev = i == 0 ? '\0' : s[i - 1];
+    if (prev == '(' && c == ')' && bracket_distance == npos) bracket_distance = i;
+    if (prev == ',' && c == ',' && consecutive_commas == npos) consecutive_commas = i;
+    if (prev == '(' && c == ',' && bracket_comma == npos) bracket_comma = i;
+    if (prev == ',' && c == ')' && comma_bracket == npos) comma_bracket = i;
+
+    if (newick)
+    {
+      if (c == '(') newick->push_back(bracket_open);
+      if (c == ')') newick->push_back(bracket_close);
+    }
+
+    if (c == '(')
+    {
+      ++n_open;
+      open_brackets.push_back( { i, false, npos } );
+      continue;
+    }
+    if (c != ')')
+    {
+      if (open_brackets.empty())
+      {
+        ++n_left;
+        if (n_left == 3) third_left = i;
+        continue;
+      }
+      OpenBracket& b = open_brackets.back();
+      if (c == ',')
+      {
+        b.has_comma = true;
+      }
+      else if (b.invalid == npos)
+      {
+        b.invalid = i;
+      }
+      continue;
+    }
+    ++n_close;
+    if (open_brackets.empty())
+    {
+      //Unmatched closing bracket, which is never cut
+      if (first_unmatched_close == npos) first_unmatched_close = i;
+      ++n_left;
+      if (n_left == 3) third_left = i;
+      continue;
+    }
+    //Cut the leaf from open_brackets.back().index to i
+    const OpenBracket b = open_brackets.back();
+    open_brackets.pop_back();
+    if (leaf_error.code == NewickErrorCode::none)
+    {
+      if (b.invalid != npos)
+      {
+        leaf_error = { NewickErrorCode::invalid_character, b.invalid };
+      }
+      else if (b.index > 0 && s[b.index - 1] == '('
+        && i + 1 < sz && s[i + 1] == ')')
+      {
+        leaf_error = { NewickErrorCode::double_brackets, b.index };
+      }
+      else if (b.index > 0 && !b.has_comma)
+      {
+        leaf_error = { NewickErrorCode::complex_leaf, b.index };
+      }
+    }
+    //The leaf becomes a single value in its parent
+    if (open_brackets.empty())
+    {
+      ++n_left;
+      if (n_left == 3) third_left = b.index;
+    }
+  }
+  //Unmatched opening brackets are never cut
+  for (const OpenBracket& b: open_brackets)
+  {
+    ++n_left;
+    if (n_left == 3) third_left = b.index;
+  }
+
+  //Return the error found first by CheckNewickByCuttingLeaves
+  if (n_open != n_close)
+  {
+    return {
+      NewickErrorCode::unmatched_brackets,
+      open_brackets.empty()
+        ? first_unmatched_close
+        : std::min(first_unmatched_close, open_brackets.front().index)
+    };
+  }
+  if (bracket_zero != npos) return { NewickErrorCode::zero_after_bracket, bracket_zero };
+  if (comma_zero != npos) return { NewickErrorCode::zero_after_comma, comma_zero };
+  if (bracket_distance != npos) return { NewickErrorCode::empty_brackets, bracket_distance };
+  if (consecutive_commas != npos) return { NewickErrorCode::consecutive_commas, consecutive_commas };
+  if (bracket_comma != npos) return { NewickErrorCode::comma_after_bracket_open, bracket_comma };
+  if (comma_bracket != npos) return { NewickErrorCode::comma_before_bracket_close, comma_bracket };
+  if (leaf_error.code != NewickErrorCode::none) return leaf_error;
+  if (n_left > 2)
+  {
+    //CheckNewickByCuttingLeaves cannot find a leaf to cut here
+    return { NewickErrorCode::outside_outer_brackets, third_left };
+  }
+  if (value_too_large != npos) return { NewickErrorCode::value_too_large, value_too_large };
+  return { NewickErrorCode::none, 0 };
+}
+
+} //~namespace
+
+void ribi::newick::CheckNewick(const std::string_view s)
+{
+  const NewickError error = ValidateNewick(s);
+  if (error.code != NewickErrorCode::none)
+  {
+    throw std::invalid_argument(GetNewickErrorMessage(error, s));
+  }
+}
+
+void ribi::newick::CheckNewickByCuttingLeaves(const std::string_view s)
 {
   CheckNewickForMinimalSize(s);
   CheckNewickForOpeningBracket(s);
@@ -323,7 +867,7 @@ void ribi::newick::CheckNewick(const std::string& s)
   CheckNewickForCommaBeforeBracketClose(s);
 
 
-  std::string s_copy = s;
+  std::string s_copy(s);
   while(s_copy.size()>2) //Find a leaf and cut it until the string is empty
   {
     //Find a leaf
@@ -451,6 +995,15 @@ void ribi::newick::CheckNewickForBracketDistance(const std::vector<int>& v)
 }
 
 void ribi::newick::CheckNewick(const std::vector<int>& v)
+{
+  const NewickError error = ValidateNewick(v);
+  if (error.code != NewickErrorCode::none)
+  {
+    throw std::invalid_argument(GetNewickErrorMessage(error, v));
+  }
+}
+
+void ribi::newick::CheckNewickByCuttingLeaves(const std::vector<int>& v)
 {
   CheckNewickForMinimalSize(v);
   CheckNewickForOpeningBracket(v);
@@ -796,7 +1349,7 @@ int ribi::newick::FindPosBefore(const std::vector<int>& v,const int x, const int
 
 std::pair<std::size_t, std::size_t>
 ribi::newick::FindOpeningAndClosingBracketIndices(
-  const std::string& s
+  const std::string_view s
 )
 {
   CheckNewickForMatchingBrackets(s);
@@ -867,21 +1420,51 @@ ribi::newick::FindOpeningAndClosingBracketIndices(
   throw std::logic_error(__func__);
 }
 
-std::vector<int> ribi::newick::GetDepth(const std::vector<int>& n) noexcept
+std::pair<std::size_t, std::size_t>
+ribi::newick::FindOpeningAndClosingBracketIndices(
+  const std::vector<int>& v,
+  const NewickIndex& index
+) noexcept
 {
-  assert(IsNewick(n));
-  std::vector<int> v;
-  int depth = -1;
-  for(const int& x: n)
+  assert(IsNewick(v));
+  assert(index.size() == v.size());
+  //The first leaf is in the first subtree of the root, if there is one,
+  //else the root is the leaf. The same goes for that subtree
+  std::size_t i = 0;
+  while (1)
   {
-    if (x == newick::bracket_open) ++depth;
-    v.push_back(depth);
-    if (x == newick::bracket_close) --depth;
+    assert(v[i] == bracket_open);
+    std::size_t child = i + 1;
+    while (child != NewickIndex::npos && v[child] != bracket_open)
+    {
+      child = index.GetNextSibling(child);
+    }
+    if (child == NewickIndex::npos)
+    {
+      return std::make_pair(i, index.GetMatchingBracket(i));
+    }
+    i = child;
   }
-  assert(n.size() == v.size());
+}
+
+std::vector<int> ribi::newick::GetCanonicalNewick(const std::vector<int>& n)
+{
+  std::vector<int> v(n);
+  CanonicalizeNewick(v.data(), v.data() + v.size());
   return v;
 }
 
+std::vector<int> ribi::newick::GetDepth(const std::vector<int>& n) noexcept
+{
+  assert(IsNewick(n));
+  return GetDepthUnchecked(n);
+}
+
+std::vector<int> ribi::newick::GetDepth(const ValidatedNewick& n) noexcept
+{
+  return GetDepthUnchecked(n.Peek());
+}
+
 std::vector<int> ribi::newick::GetFactorialTerms(const int n) noexcept
 {
   assert(n > 0);
@@ -899,24 +1482,36 @@ std::vector<boost::tuple<std::string,double,double> > ribi::newick::GetKnownProb
 int ribi::newick::GetLeafMaxArity(const std::vector<int>& n) noexcept
 {
   assert(IsNewick(n));
-  const int size = boost::numeric_cast<int>(n.size());
-  if (IsSimple(n)) return size - 2;
+  return GetLeafMaxArityUnchecked(n);
+}
 
+int ribi::newick::GetLeafMaxArity(const ValidatedNewick& n) noexcept
+{
+  return GetLeafMaxArityUnchecked(n.Peek());
+}
+
+int ribi::newick::GetLeafMaxArity(
+  const std::vector<int>& n,
+  const NewickIndex& index
+) noexcept
+{
+  assert(IsNewick(n));
+  assert(index.size() == n.size());
+  const std::size_t size = n.size();
   int max = 0;
-  for (int from = 0; from!=size; ++from)
+  for (std::size_t from = 0; from!=size; ++from)
   {
     if (n[from] != newick::bracket_open) continue;
-    for (int to = from+1; to!=size; ++to)
+    //Only a subtree without subtrees is a leaf
+    bool is_leaf = true;
+    for (std::size_t child = from + 1; child != NewickIndex::npos; child = index.GetNextSibling(child))
     {
-      if (n[to] == newick::bracket_open) break;
-      if (n[to]  > 0) continue;
-      if (n[to] == newick::bracket_close)
-      {
-        assert(from < to);
-        max = to - from - 1;
-        break;
-      }
+      if (n[child] == newick::bracket_open) { is_leaf = false; break; }
     }
+    if (!is_leaf) continue;
+    const std::size_t to = index.GetMatchingBracket(from);
+    assert(from < to);
+    max = std::max(max, static_cast<int>(to - from - 1));
   }
   return max;
 }
@@ -927,6 +1522,34 @@ std::vector<std::vector<int> >
   return NewickCpp98().GetRootBranches(n);
 }
 
+std::vector<std::vector<int> >
+  ribi::newick::GetRootBranches(
+    const std::vector<int>& n,
+    const NewickIndex& index
+) noexcept
+{
+  assert(IsNewick(n));
+  assert(!IsUnaryNewick(n));
+  assert(index.size() == n.size());
+  std::vector<std::vector<int> > v;
+  for (std::size_t i = 1; i != NewickIndex::npos; i = index.GetNextSibling(i))
+  {
+    if (n[i] > 0)
+    {
+      v.push_back(Surround(n[i]));
+    }
+    else
+    {
+      assert(n[i] == bracket_open);
+      const std::size_t j = index.GetMatchingBracket(i);
+      v.push_back(std::vector<int>(n.begin() + i, n.begin() + j + 1));
+    }
+    assert(IsNewick(v.back()));
+  }
+  assert(v.size() > 1);
+  return v;
+}
+
 std::pair<std::vector<int>,std::vector<int> >
   ribi::newick::GetRootBranchesBinary(const std::vector<int>& n) noexcept
 {
@@ -1095,58 +1718,27 @@ std::vector<std::vector<int>>
     newicks.push_back(next);
   }
   else
-  {
-    std::vector<int> next(n);
-    --next[2];
-    assert(newick::IsNewick(next));
-    newicks.push_back(next);
-  }
-  return newicks;
-}
-
-std::vector<std::vector<int>>
-  ribi::newick::GetSimplerNewicksEasy(const std::vector<int>& n) noexcept
-{
-  assert(IsNewick(n));
-  std::vector<std::vector<int>> newicks;
-  const int size = boost::numeric_cast<int>(n.size());
-
-  for (int i = 0; i!=size; ++i)
-  {
-    assert(i >= 0);
-    assert(i < size);
-    if (n[i] < 1) continue;
-    assert(n[i] > 0);
-    //If a frequency is above one, it is easy to create the simpler newicks
-    if (n[i] > 1)
-    {
-      std::vector<int> new_newick(n);
-      --new_newick[i];
-      newicks.push_back(new_newick);
-    }
+  {
+    std::vector<int> next(n);
+    --next[2];
+    assert(newick::IsNewick(next));
+    newicks.push_back(next);
   }
   return newicks;
 }
 
 std::vector<std::vector<int>>
-  ribi::newick::GetSimplerNewicksHard(const std::vector<int>& n) noexcept
+  ribi::newick::GetSimplerNewicksEasy(const std::vector<int>& n) noexcept
 {
   assert(IsNewick(n));
-  std::vector<std::vector<int>> newicks;
-  const int size = boost::numeric_cast<int>(n.size());
+  return GetSimplerNewicksEasyUnchecked(n);
+}
 
-  //Go through all positions
-  for (int i = 0; i!=size; ++i)
-  {
-    assert(i >= 0);
-    assert(i < size);
-    if (n[i] != 1) continue;
-    //If a frequency is one, the Newick needs to be simplified
-    assert(n[i] == 1); //Most difficult...
-    const auto v = GetSimplerNewicksHardFromHere(n, i);
-    std::copy(std::begin(v), std::end(v), std::back_inserter(newicks));
-  }
-  return newicks;
+std::vector<std::vector<int>>
+  ribi::newick::GetSimplerNewicksHard(const std::vector<int>& n) noexcept
+{
+  assert(IsNewick(n));
+  return GetSimplerNewicksHardUnchecked(n);
 }
 
 std::vector<std::vector<int>>
@@ -1155,89 +1747,37 @@ ribi::newick::GetSimplerNewicksHardFromHere(
     const int i
 ) noexcept
 {
-  const std::vector<int> depths = GetDepth(n);
-  const int size = boost::numeric_cast<int>(n.size());
-  assert(i >= 0);
-  assert(i < size);
-  assert(n[i] == 1); //Otherwise it would not be hard
-  std::vector<std::vector<int>> newicks;
+  return GetSimplerNewicksHardFromHereUnchecked(n, i, NewickIndex(n));
+}
 
-  const int depth = depths[i];
-  //j must first decrement, later increment with the same code
-  int j_end  = -1;
-  int j_step = -1;
-  for (int j=i-1; ; j+=j_step)
-  {
-    //j must first decrement, later increment with the same code
-    if (j == j_end || (depths[j] == depth && n[j] < 0))
-    {
-      if (j_step == -1)
-      {
-        j = i + 1;
-        j_end = size;
-        j_step = 1;
-      }
-      else
-      {
-        break;
-      }
-    }
-    assert(i!=j);
-    assert(j >= 0);
-    assert(j < size);
-    //Only take frequencies of the same depth into account
-    if (n[j] < 1 || depths[j] != depth) continue;
-    std::vector<int> new_newick_with_zero(n);
-    --new_newick_with_zero[i];
-    assert(new_newick_with_zero[i] == 0);
-    ++new_newick_with_zero[j];
-    //Remove brackets after possibly lonely value
-    //If there is only one or two values between
-    //the brackets, and one of these values was a
-    //1 becoming added to the other, nullify the
-    //1 and both brackets:
-    //'((1,1),2)' -> '(00102)' -> '(1,2)'
-    if (std::abs(i - j) == 1)
-    {
-      const int index_bracket_open  = std::min(i,j) - 1;
-      const int index_bracket_close = std::max(i,j) + 1;
-      if ( new_newick_with_zero[index_bracket_open]  == newick::bracket_open
-        && new_newick_with_zero[index_bracket_close] == newick::bracket_close)
-      {
-        new_newick_with_zero[index_bracket_open]  = 0;
-        new_newick_with_zero[index_bracket_close] = 0;
-      }
-    }
-    //Remove decremented i and possibly nullified brackets
-    std::vector<int> new_newick;
-    std::remove_copy(
-      new_newick_with_zero.begin(),
-      new_newick_with_zero.end(),
-      std::back_inserter(new_newick),
-      0);
-    //Add brackets if these are removed
-    if (new_newick.front() != newick::bracket_open
-      || new_newick.back() != newick::bracket_close)
-    {
-      new_newick = newick::Surround(new_newick);
-    }
-    assert(IsNewick(new_newick));
-    newicks.push_back(new_newick);
-  }
-  return newicks;
+std::vector<std::vector<int>>
+ribi::newick::GetSimplerNewicksHardFromHere(
+    const std::vector<int>& n,
+    const int i,
+    const NewickIndex& index
+) noexcept
+{
+  assert(IsNewick(n));
+  return GetSimplerNewicksHardFromHereUnchecked(n, i, index);
 }
 
 std::vector<std::vector<int>>
   ribi::newick::GetSimplerNewicks(const std::vector<int>& n) noexcept
 {
   assert(IsNewick(n));
-  std::vector<std::vector<int>> newicks = GetSimplerNewicksEasy(n);
-  const std::vector<std::vector<int>> hard_newicks = GetSimplerNewicksHard(n);
-  std::copy(
-    std::begin(hard_newicks),
-    std::end(hard_newicks),
-    std::back_inserter(newicks)
-  );
+  return GetSimplerNewicksUnchecked(n);
+}
+
+std::vector<ribi::newick::ValidatedNewick>
+  ribi::newick::GetSimplerNewicks(const ValidatedNewick& n)
+{
+  const std::vector<std::vector<int>> v = GetSimplerNewicksUnchecked(n.Peek());
+  std::vector<ValidatedNewick> newicks;
+  newicks.reserve(v.size());
+  for (const std::vector<int>& w: v)
+  {
+    newicks.push_back(ValidatedNewick(w, ValidatedNewick::Unchecked()));
+  }
   return newicks;
 }
 
@@ -1246,7 +1786,44 @@ std::vector<std::pair<std::vector<int>,int> >
   const std::vector<int>& n
 )
 {
-  return NewickCpp98().GetSimplerNewicksFrequencyPairs(n);
+  std::vector<std::pair<std::vector<int>,int>> newicks;
+  GetSimplerNewicksFrequencyPairs(n, newicks);
+  return newicks;
+}
+
+void ribi::newick::GetSimplerNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<std::pair<std::vector<int>,int>>& newicks
+)
+{
+  std::vector<int> buffer;
+  buffer.reserve(n.size());
+  GetSimplerNewicksFrequencyPairs(n, newicks, buffer);
+}
+
+void ribi::newick::GetSimplerNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<std::pair<std::vector<int>,int>>& newicks,
+  std::vector<int>& buffer
+)
+{
+  std::size_t sz = 0;
+  VisitSimplerNewicksFrequencyPairs(n, buffer,
+    [&newicks, &sz](const std::vector<int>& newick, const int frequency)
+    {
+      if (sz == newicks.size())
+      {
+        newicks.push_back(std::make_pair(newick, frequency));
+      }
+      else
+      {
+        newicks[sz].first.assign(std::begin(newick), std::end(newick));
+        newicks[sz].second = frequency;
+      }
+      ++sz;
+    }
+  );
+  newicks.resize(sz);
 }
 
 
@@ -1266,6 +1843,54 @@ std::vector<std::pair<std::vector<int>,int> >
   return GetSimplerBinaryNewicksFrequencyPairsComplex(n);
 }
 
+void ribi::newick::GetSimplerBinaryNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<std::pair<std::vector<int>,int>>& newicks
+)
+{
+  assert(IsBinaryNewick(n) || IsUnaryNewick(n));
+  std::size_t sz = 0;
+  //The next element of newicks to write to, reusing its capacity
+  const auto next = [&newicks, &sz](const int frequency) -> std::vector<int>&
+  {
+    if (sz == newicks.size()) newicks.push_back(std::make_pair(std::vector<int>(), 0));
+    newicks[sz].second = frequency;
+    std::vector<int>& newick = newicks[sz].first;
+    newick.clear();
+    ++sz;
+    return newick;
+  };
+  const int size = n.size();
+  for (int i=0; i!=size; ++i)
+  {
+    if (n[i] < 1) continue;
+    if (n[i] > 1)
+    {
+      std::vector<int>& newick = next(n[i]);
+      newick.assign(std::begin(n), std::end(n));
+      --newick[i];
+      continue;
+    }
+    //The 1 is added to its neighbour, if that is its sibling frequency
+    const int j = n[i - 1] > 0 ? i - 1 : i + 1;
+    if (n[j] < 1) continue;
+    //Both brackets are removed, unless these are the outer brackets:
+    //'((1,1),2)' -> '(2,2)', '(1,2)' -> '(3)'
+    const int first = std::min(i,j);
+    const bool is_root = first == 1 && size == 4;
+    std::vector<int>& newick = next(1);
+    const int from = is_root ? 0 : first - 1;
+    const int to = is_root ? size : first + 3;
+    newick.insert(std::end(newick), std::begin(n), std::begin(n) + from);
+    if (is_root) newick.push_back(bracket_open);
+    newick.push_back(n[j] + 1);
+    if (is_root) newick.push_back(bracket_close);
+    newick.insert(std::end(newick), std::begin(n) + to, std::end(n));
+    assert(IsNewick(newick));
+  }
+  newicks.resize(sz);
+}
+
 std::vector<std::pair<std::vector<int>,int> >
   ribi::newick::GetSimplerBinaryNewicksFrequencyPairsSimple(
   const std::vector<int>& n) noexcept
@@ -1384,6 +2009,112 @@ std::vector<std::pair<std::vector<int>,int> >
   return v;
 }
 
+std::string ribi::newick::GetNewickErrorMessage(
+  const NewickError& error,
+  const std::string_view s
+)
+{
+  switch (error.code)
+  {
+    case NewickErrorCode::none:
+      return "";
+    case NewickErrorCode::too_short:
+      return "The Newick std::string must have a size of "
+        "at least three characters";
+    case NewickErrorCode::no_opening_bracket:
+      return "The Newick std::string must start with "
+        "an opening bracket ('(').";
+    case NewickErrorCode::no_closing_bracket:
+      return "The Newick std::string must end with "
+        "a closing bracket (')').";
+    case NewickErrorCode::unmatched_brackets:
+      return "The Newick std::string must have as much opening "
+        "as closing brackets";
+    case NewickErrorCode::zero_after_bracket:
+      return "A std::string Newick frequency cannot be or "
+        "start with a zero (#1)";
+    case NewickErrorCode::zero_after_comma:
+      return "A std::string Newick frequency cannot be or "
+        "start with a zero (#2)";
+    case NewickErrorCode::empty_brackets:
+      return "The Newick std::string cannot have "
+        "a consecutive opening and closing bracket";
+    case NewickErrorCode::consecutive_commas:
+      return "A Newick std::string can have no consecutive comma's";
+    case NewickErrorCode::comma_after_bracket_open:
+      return "A Newick std::string cannot have comma "
+        "directly after an opening bracket";
+    case NewickErrorCode::comma_before_bracket_close:
+      return "A Newick std::string cannot have comma "
+        "directly before a closing bracket";
+    case NewickErrorCode::invalid_character:
+    {
+      assert(error.position < s.size());
+      std::stringstream err_msg;
+      err_msg << "Invalid non-number character in input: '" << s[error.position] << "'";
+      return err_msg.str();
+    }
+    case NewickErrorCode::double_brackets:
+      return "Newicks must not have the form ((X))";
+    case NewickErrorCode::complex_leaf:
+      return "The Newick std::string cannot have the sequence "
+        "of an opening bracket, a value and a closing bracket "
+        "as a \'complex\' leaf";
+    case NewickErrorCode::outside_outer_brackets:
+      return "The Newick std::string must not have values "
+        "or brackets outside of its outer brackets";
+    case NewickErrorCode::value_too_large:
+      return "A std::string Newick frequency must fit in an int";
+    default:
+      break;
+  }
+  assert(!"Should not get here: error code is for std::vector<int> Newicks only"); //!OCLINT accepted idiom
+  throw std::logic_error(__func__);
+}
+
+std::string ribi::newick::GetNewickErrorMessage(
+  const NewickError& error,
+  const std::vector<int>& v
+)
+{
+  switch (error.code)
+  {
+    case NewickErrorCode::none:
+      return "";
+    case NewickErrorCode::too_short:
+      return "The Newick std::vector<int> must have "
+        "a size of at least three characters";
+    case NewickErrorCode::no_opening_bracket:
+      return "The Newick std::vector<int> must start with "
+        "an opening bracket ('(').";
+    case NewickErrorCode::no_closing_bracket:
+      return "The Newick std::vector<int> must end with "
+        "a closing bracket (')').";
+    case NewickErrorCode::unmatched_brackets:
+      return "The Newick std::string must have as much opening "
+        "as closing brackets";
+    case NewickErrorCode::zero_value:
+      return "A std::vector<int> Newick frequency cannot be zero";
+    case NewickErrorCode::empty_brackets:
+      return "The Newick std::vector<int> cannot have "
+        "a consecutive opening and closing bracket";
+    case NewickErrorCode::invalid_value:
+    {
+      assert(error.position < v.size());
+      std::ostringstream err_msg;
+      err_msg << "Invalid non-number in input: '" << v[error.position] << "'";
+      return err_msg.str();
+    }
+    case NewickErrorCode::outside_outer_brackets:
+      return "The Newick std::vector<int> must not have values "
+        "or brackets outside of its outer brackets";
+    default:
+      break;
+  }
+  assert(!"Should not get here: error code is for std::string Newicks only"); //!OCLINT accepted idiom
+  throw std::logic_error(__func__);
+}
+
 std::string ribi::newick::GetNewickVersion() noexcept
 {
   return "2.0";
@@ -1402,75 +2133,48 @@ void ribi::newick::InspectInvalidNewick(std::ostream& os, const std::vector<int>
 {
   os << "InspectInvalidNewick on: "
     << DumbNewickToString(v) << '\n';
-  try
-  {
-    newick::CheckNewick(v);
-  }
-  catch (std::exception& e)
+  const NewickError error = ValidateNewick(v);
+  if (error.code != NewickErrorCode::none)
   {
-    os << "Invalidity caused by: " << e.what() << '\n';
+    os << "Invalidity caused by: " << GetNewickErrorMessage(error, v) << '\n';
   }
 }
 
-bool ribi::newick::IsNewick(const std::string& s) noexcept
+bool ribi::newick::IsNewick(const std::string_view s) noexcept
 {
-  try
-  {
-    CheckNewick(s);
-  }
-  catch (const std::exception&)
-  {
-    return false;
-  }
-  return true;
+  return ValidateNewick(s).code == NewickErrorCode::none;
 }
 
 bool ribi::newick::IsNumberOrComma(const char c) noexcept
 {
-  const std::string s{"0123456789,"};
-  return s.find(c) != std::string::npos;
+  return (c >= '0' && c <= '9') || c == ',';
 }
 
 bool ribi::newick::IsSimple(const std::vector<int>& v) noexcept
 {
   assert(newick::IsNewick(v));
-  //A Newick is simple if it contains no '(' after the initial one
-  return std::count(
-    v.begin()+1,v.end(),
-    static_cast<int>(bracket_open)
-  ) == 0;
+  return IsSimpleUnchecked(v);
+}
+
+bool ribi::newick::IsSimple(const ValidatedNewick& v) noexcept
+{
+  return IsSimpleUnchecked(v.Peek());
 }
 
 bool ribi::newick::IsBinaryNewick(std::vector<int> v) noexcept
 {
   assert(newick::IsNewick(v));
-  if (IsUnaryNewick(v)) return false;
+  return IsBinaryNewickUnchecked(std::move(v));
+}
 
-  while (1)
-  {
-    const int sz = boost::numeric_cast<int>(v.size());
-    //Only numbers?
-    if (IsSimple(v))
-    {
-      //Binary Newick has size 4, for example '(1,2)'
-      return sz == 4;
-    }
-    if (GetLeafMaxArity(v) > 2) return false;
-    v = newick::ReplaceLeave(v,42);
-  }
+bool ribi::newick::IsBinaryNewick(const ValidatedNewick& v) noexcept
+{
+  return IsBinaryNewickUnchecked(v.Peek());
 }
 
 bool ribi::newick::IsNewick(const std::vector<int>& v) noexcept
 {
-  try
-  {
-    CheckNewick(v);
-  }
-  catch (...)
-  {
-    return false;
-  }
-  return true;
+  return ValidateNewick(v).code == NewickErrorCode::none;
 }
 
 ///IsTrinaryNewick checks if a Newick is a trinary tree,
@@ -1479,35 +2183,23 @@ bool ribi::newick::IsNewick(const std::vector<int>& v) noexcept
 bool ribi::newick::IsTrinaryNewick(std::vector<int> v) noexcept
 {
   assert(newick::IsNewick(v));
-  if (IsUnaryNewick(v)) return false;
-  if (IsBinaryNewick(v)) return false;
-
-  bool trinarity_found = false;
-
-  while (1)
-  {
-    const int sz = boost::numeric_cast<int>(v.size());
-    //Only numbers?
-    if (IsSimple(v))
-    {
-      //Ternary Newick has size 5, for example '(1,2,3)'
-      return trinarity_found || sz == 5;
-    }
-    const int leaf_max_arity = GetLeafMaxArity(v);
-    if (leaf_max_arity > 3) return false;
-    if (leaf_max_arity == 3) trinarity_found = true;
+  return IsTrinaryNewickUnchecked(std::move(v));
+}
 
-    v = newick::ReplaceLeave(v,42);
-  }
+bool ribi::newick::IsTrinaryNewick(const ValidatedNewick& v) noexcept
+{
+  return IsTrinaryNewickUnchecked(v.Peek());
 }
 
 bool ribi::newick::IsUnaryNewick(const std::vector<int>& v) noexcept
 {
   assert(newick::IsNewick(v));
-  return v.size() == 3
-    && v[0] == newick::bracket_open
-    && v[1] >  0
-    && v[2] == newick::bracket_close;
+  return IsUnaryNewickUnchecked(v);
+}
+
+bool ribi::newick::IsUnaryNewick(const ValidatedNewick& v) noexcept
+{
+  return IsUnaryNewickUnchecked(v.Peek());
 }
 
 std::string ribi::newick::NewickToString(const std::vector<int>& v)
@@ -1556,36 +2248,46 @@ std::string ribi::newick::NewickToString(const std::vector<int>& v)
   return s;
 }
 
+ribi::newick::NewickError ribi::newick::ParseNewick(
+  const std::string_view s,
+  std::vector<int>& newick
+)
+{
+  newick.clear();
+  return ScanNewick(s, &newick);
+}
+
 std::vector<int> ribi::newick::ReplaceLeave(
   const std::vector<int>& newick,
   const int value
 )
 {
   assert(IsNewick(newick) && "Only a valid Newick can have its leaves replaced");
-  assert(!IsSimple(newick) && "There must a leaf to simplify");
-  typedef std::vector<int>::const_iterator Iterator;
-  const Iterator end = newick.end();
-  for (Iterator from = newick.begin(); from!=end; ++from)
-  {
-    if (*from != newick::bracket_open) continue;
+  return ReplaceLeaveUnchecked(newick, value);
+}
 
-    for (Iterator to = from + 1; to!=end; ++to)
-    {
-      if (*to > 0) continue;
-      if (*to == newick::bracket_open) break;
-      if (*to == newick::bracket_close)
-      {
-        //Found
-        std::vector<int> new_newick(newick.begin(),from);
-        new_newick.push_back(value);
-        std::copy(to + 1,newick.end(),std::back_inserter(new_newick));
-        assert(newick::IsNewick(new_newick));
-        return new_newick;
-      }
-    }
+ribi::newick::ValidatedNewick ribi::newick::ReplaceLeave(
+  const ValidatedNewick& newick,
+  const int value
+)
+{
+  //Both would create an invalid ValidatedNewick
+  if (value < 1)
+  {
+    throw std::invalid_argument(
+      "A leaf can only be replaced by a frequency of at least one"
+    );
   }
-  assert(!"Should not get here"); //!OCLINT
-  throw std::logic_error("Should not get here");
+  if (IsSimple(newick))
+  {
+    throw std::invalid_argument(
+      "A simple Newick has no leaf to replace"
+    );
+  }
+  return ValidatedNewick(
+    ReplaceLeaveUnchecked(newick.Peek(), value),
+    ValidatedNewick::Unchecked()
+  );
 }
 
 void ribi::newick::StoreAllNewLeafs(
@@ -1613,7 +2315,7 @@ void ribi::newick::StoreAllNewLeafs(
   }
 }
 
-std::vector<int> ribi::newick::StringToNewick(const std::string& newick)
+std::vector<int> ribi::newick::StringToNewick(const std::string_view newick)
 {
   assert(IsNewick(newick));
   assert(!newick.empty()
@@ -1624,35 +2326,25 @@ std::vector<int> ribi::newick::StringToNewick(const std::string& newick)
     && "s must end with a ')'");
 
   std::vector<int> v;
-  int value = 0;
-
-  for(const char i: newick)
-  {
-    if (i == '(')
-    {
-      if (value!=0) v.push_back(value);
-      value = 0;
-      v.push_back(bracket_open);
-      continue;
-    }
-    if (i == ')')
+  //Only the non-digit characters are visited one by one,
+  //the digits in between are read as a value
+  NewickStructuralScanner scanner(newick);
+  std::size_t value_begin = 0;
+  for (std::size_t i = scanner.Next(); i != newick.size(); i = scanner.Next())
+  {
+    int value = 0;
+    for (std::size_t j=value_begin; j!=i; ++j)
     {
-      if (value!=0) v.push_back(value);
-      value = 0;
-      v.push_back(bracket_close);
-      continue;
-    }
-    if (i == ',')
-    {
-      if (value!=0) v.push_back(value);
-      value = 0;
-      continue;
+      value*=10;
+      value+=newick[j] - '0';
     }
-    assert(i >= '0' && i <= '9'); //Should be a number
-    value*=10;
-    value+=boost::lexical_cast<int>(i);
+    if (value!=0) v.push_back(value);
+    value_begin = i + 1;
+    if (newick[i] == '(') v.push_back(bracket_open);
+    else if (newick[i] == ')') v.push_back(bracket_close);
+    else assert(newick[i] == ','); //Should be a comma
   }
-  assert(value == 0 && "Final bracket close must set value to zero");
+  assert(value_begin == newick.size() && "Final bracket close must end the Newick");
   return v;
 }
 
@@ -1673,3 +2365,126 @@ std::vector<int> ribi::newick::Surround(const int f) noexcept
     static_cast<int>(newick::bracket_close)
   );
 }
+
+ribi::newick::NewickError ribi::newick::ValidateNewick(const std::string_view s) noexcept
+{
+  return ScanNewick(s, nullptr);
+}
+
+ribi::newick::NewickError ribi::newick::ValidateNewick(const std::vector<int>& v) noexcept
+{
+  const std::size_t sz = v.size();
+  if (sz < 3) return { NewickErrorCode::too_short, 0 };
+  if (v[0] != bracket_open) return { NewickErrorCode::no_opening_bracket, 0 };
+  if (v[sz - 1] != bracket_close) return { NewickErrorCode::no_closing_bracket, sz - 1 };
+
+  //Single pass over v, that collects the violations of the
+  //CheckNewickFor* functions and meanwhile cuts the leaves in
+  //the same order as CheckNewickByCuttingLeaves does: a leaf is cut
+  //at each closing bracket. Only the depth is tracked, as the
+  //first leaf with an invalid value is the first one to be
+  //closed at the depth of that value
+  const std::size_t npos = std::string::npos;
+  int n_open = 0;
+  int n_close = 0;
+  std::size_t first_unmatched_close = npos;
+  std::size_t zero = npos;
+  std::size_t bracket_distance = npos;
+
+  //The first invalid value found in a leaf that is cut
+  std::size_t leaf_error = npos;
+
+  //The first invalid value found in a leaf that is not cut yet
+  std::size_t pending = npos;
+  int pending_depth = 0; //0: there is no pending invalid value
+
+  //The number of values left after all leaves are cut
+  int n_left = 0;
+  std::size_t third_left = npos;
+
+  //Index of the last opening bracket at depths one to three,
+  //which are the leftmost unmatched opening brackets at the end
+  std::size_t last_open[4] = { npos, npos, npos, npos };
+
+  int depth = 0;
+  int prev = 0;
+  for (std::size_t i=0; i!=sz; ++i)
+  {
+    const int x = v[i];
+    if (x == 0 && zero == npos) zero = i;
+    if (prev == bracket_open && x == bracket_close && bracket_distance == npos) bracket_distance = i;
+    prev = x;
+
+    if (x == bracket_open)
+    {
+      ++n_open;
+      ++depth;
+      if (depth < 4) last_open[depth] = i;
+      continue;
+    }
+    if (x != bracket_close)
+    {
+      if (depth == 0)
+      {
+        ++n_left;
+        if (n_left == 3) third_left = i;
+      }
+      else if (x < 0 && leaf_error == npos && depth > pending_depth)
+      {
+        //If there already is a pending value, its leaf is
+        //cut after the leaf of this value
+        pending = i;
+        pending_depth = depth;
+      }
+      continue;
+    }
+    ++n_close;
+    if (depth == 0)
+    {
+      //Unmatched closing bracket, which is never cut
+      if (first_unmatched_close == npos) first_unmatched_close = i;
+      ++n_left;
+      if (n_left == 3) third_left = i;
+      continue;
+    }
+    //Cut the leaf that ends here
+    if (depth == pending_depth)
+    {
+      leaf_error = pending;
+      pending_depth = 0;
+    }
+    --depth;
+    //The leaf becomes a single value in its parent
+    if (depth == 0)
+    {
+      ++n_left;
+      if (n_left == 3) third_left = last_open[1];
+    }
+  }
+  //Unmatched opening brackets are never cut
+  for (int d=1; d<=depth; ++d)
+  {
+    ++n_left;
+    if (n_left == 3) third_left = last_open[d];
+  }
+
+  //Return the error found first by CheckNewickByCuttingLeaves
+  if (n_open != n_close)
+  {
+    return {
+      NewickErrorCode::unmatched_brackets,
+      depth == 0
+        ? first_unmatched_close
+        : std::min(first_unmatched_close, last_open[1])
+    };
+  }
+  if (zero != npos) return { NewickErrorCode::zero_value, zero };
+  if (bracket_distance != npos) return { NewickErrorCode::empty_brackets, bracket_distance };
+  if (leaf_error != npos) return { NewickErrorCode::invalid_value, leaf_error };
+  if (n_left > 2)
+  {
+    //CheckNewickByCuttingLeaves cannot find a leaf to cut here
+    return { NewickErrorCode::outside_outer_brackets, third_left };
+  }
+  return { NewickErrorCode::none, 0 };
+}
@@ -1,8 +1,13 @@
 #ifndef NEWICK_H
 #define NEWICK_H
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <map>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 
@@ -14,6 +19,7 @@
 
 #include "BigIntegerLibrary.hh"
 #include "newickcpp98.h"
+#include "newicklanes.h"
 #include "newickstorage.h"
 
 
@@ -21,6 +27,9 @@ namespace ribi {
 
 namespace newick {
 
+struct NewickIndex;
+struct ValidatedNewick;
+
 ///CalcComplexity calculates the complexity of a Newick.
 ///From http://www.richelbilderbeek.nl/CppCalcComplexity.htm
 BigInteger CalcComplexity(const std::vector<int>& v);
@@ -60,6 +69,16 @@ double CalcDenominator(const std::vector<int>& v,const double theta);
 ///a Newick for a value of theta
 ///using the Ewens formula
 double CalcProbabilitySimpleNewick(const std::vector<int>& v,const double theta);
+double CalcProbabilitySimpleNewick(const ValidatedNewick& v,const double theta);
+
+///CanonicalizeNewick sorts the children of each node of the valid Newick
+///in [begin,end), in place and without allocating memory.
+///Children are sorted lexicographically on their (sorted) elements,
+///so subtrees come before frequencies.
+///Newicks that only differ in the order of siblings, like '((1,2),3)'
+///and '(3,(2,1))', have the same probability and become equal.
+///Returns true if any children were reordered
+bool CanonicalizeNewick(int * const begin, int * const end) noexcept;
 
 ///Count the number of adjacent non-zero positive values
 int CountAdjacentNonZeroPositives(const std::vector<int>& v);
@@ -103,6 +122,10 @@ int Factorial(const int n) noexcept;
 int FindPosAfter(const std::vector<int>& v,const int index,const int value) noexcept;
 int FindPosBefore(const std::vector<int>& v,const int index,const int value) noexcept;
 
+///GetCanonicalNewick returns the Newick with the children of each node sorted,
+///see CanonicalizeNewick. For example, '(3,(2,1))' becomes '((1,2),3)'
+std::vector<int> GetCanonicalNewick(const std::vector<int>& n);
+
 ///GetDepth returns the depth of each Newick element
 ///Example #1
 ///(1,2,3)
@@ -114,6 +137,7 @@ int FindPosBefore(const std::vector<int>& v,const int index,const int value) noe
 ///... .. .. .2 22.. <- depth layer 2
 ///011 11 11 22 2210 <- result of GetDepth
 std::vector<int> GetDepth(const std::vector<int>& n) noexcept;
+std::vector<int> GetDepth(const ValidatedNewick& n) noexcept;
 
 
 ///GetFactorialTerms returns all terms from a factorial.
@@ -123,6 +147,11 @@ std::vector<int> GetFactorialTerms(const int n) noexcept;
 
 std::vector<boost::tuple<std::string,double,double> > GetKnownProbabilities() noexcept;
 int GetLeafMaxArity(const std::vector<int>& n) noexcept;
+int GetLeafMaxArity(const ValidatedNewick& n) noexcept;
+
+///GetLeafMaxArity using the NewickIndex of Newick n,
+///instead of scanning n for the matching brackets
+int GetLeafMaxArity(const std::vector<int>& n, const NewickIndex& index) noexcept;
 
 
 ///GetRootBranches obtains the root branches from a non-unary Newick.
@@ -134,6 +163,11 @@ int GetLeafMaxArity(const std::vector<int>& n) noexcept;
 std::vector<std::vector<int> >
   GetRootBranches(const std::vector<int>& n) noexcept;
 
+///GetRootBranches using the NewickIndex of Newick n,
+///which visits the root branches without calculating the depths
+std::vector<std::vector<int> >
+  GetRootBranches(const std::vector<int>& n, const NewickIndex& index) noexcept;
+
 ///GetRootBranchesBinary obtains the two root branches from a binary Newick.
 ///Examples:
 ///(1,2)                 -> { 1             , 2     }
@@ -167,6 +201,17 @@ std::vector<std::pair<std::vector<int>,int> >
   const std::vector<int>& n
 ) noexcept;
 
+///GetSimplerBinaryNewicksFrequencyPairs writes the simpler Newicks of a binary
+///(or unary) Newick and their frequencies to newicks, reusing its elements and
+///their capacities. Its simpler Newicks are identical to those of
+///GetSimplerNewicksFrequencyPairs, yet as a frequency of one can only be added
+///to its neighbour, no depths or siblings are searched.
+///Does not allocate memory if newicks is big enough
+void GetSimplerBinaryNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<std::pair<std::vector<int>,int>>& newicks
+);
+
 ///GetSimplerBinaryNewicksFrequencyPairs for a simple newick.
 std::vector<std::pair<std::vector<int>,int> >
   GetSimplerBinaryNewicksFrequencyPairsSimple(
@@ -191,19 +236,23 @@ void InspectInvalidNewick(std::ostream& os, const std::vector<int>& v) noexcept;
 ///that is: each node splits in two (not more) branches
 ///From http://www.richelbilderbeek.nl/CppIsBinaryNewick.htm
 bool IsBinaryNewick(std::vector<int> v) noexcept;
+bool IsBinaryNewick(const ValidatedNewick& v) noexcept;
 
 bool IsTrinaryNewick(std::vector<int> v) noexcept;
+bool IsTrinaryNewick(const ValidatedNewick& v) noexcept;
 
 ///IsUnaryNewick checks if a Newick is a unary tree,
 ///that is: there is only one node.
 ///From http://www.richelbilderbeek.nl/CppIsUnaryNewick.htm
 bool IsUnaryNewick(const std::vector<int>& v) noexcept;
+bool IsUnaryNewick(const ValidatedNewick& v) noexcept;
 
 ///IsSimple returns true if the Newick std::vector contains
 ///leaves only. For example, the Newick '(1,2,3)' is simple,
 ///the Newick '((1,2),3)' is not simple
 ///From http://www.richelbilderbeek.nl/CppIsNewick.htm
 bool IsSimple(const std::vector<int>& v) noexcept;
+bool IsSimple(const ValidatedNewick& v) noexcept;
 
 ///NewickToString converts a Newick std::vector<int> to a
 ///standard-format std::string.
@@ -214,12 +263,14 @@ std::string NewickToString(const std::vector<int>& v);
 ///For example, using ReplaceLeave on '((1,2),(3,4))' with a value
 ///of 42 results in '(42,(3,4))'.
 std::vector<int> ReplaceLeave(const std::vector<int>& newick, const int value);
+///Throws std::invalid_argument if value is less than one or newick is simple
+ValidatedNewick ReplaceLeave(const ValidatedNewick& newick, const int value);
 
 ///StringToNewick converts a std::string to a Newick std::vector<int>
 ///StringToNewick assumes that the input is well-formed and
 ///has both trailing and tailing brackets.
 ///From http://www.richelbilderbeek.nl/CppNewickToVector.htm
-std::vector<int> StringToNewick(const std::string& newick);
+std::vector<int> StringToNewick(const std::string_view newick);
 
 enum { bracket_open  = -1 };
 enum { bracket_close = -2 };
@@ -227,62 +278,129 @@ enum { comma         = -3 };
 enum { new_line      = -4 };
 enum { null          = -5 };
 
+///NewickErrorCode is the reason why a Newick is invalid
+enum class NewickErrorCode
+{
+  none,                       //The Newick is valid
+  too_short,                  //Less than three characters
+  no_opening_bracket,         //Does not start with '('
+  no_closing_bracket,         //Does not end with ')'
+  unmatched_brackets,         //Unequal number of '(' and ')'
+  zero_after_bracket,         //'(0'
+  zero_after_comma,           //',0'
+  empty_brackets,             //'()'
+  consecutive_commas,         //',,'
+  comma_after_bracket_open,   //'(,'
+  comma_before_bracket_close, //',)'
+  invalid_character,          //Not a number, comma or bracket
+  double_brackets,            //'((X))'
+  complex_leaf,               //'(X)' that is not the root, e.g. '(1,(2))'
+  outside_outer_brackets,     //e.g. '(1),(2)'
+  value_too_large,            //A frequency does not fit in an int
+  zero_value,                 //A frequency of zero, std::vector<int> only
+  invalid_value               //A negative non-bracket, std::vector<int> only
+};
+
+///NewickError is the reason why a Newick is invalid
+///and the index of the character or value at which this is detected
+struct NewickError
+{
+  NewickErrorCode code;
+  std::size_t position;
+};
+
+///GetNewickErrorMessage returns the description of a NewickError
+///in Newick std::string s, which is the message thrown by CheckNewick
+std::string GetNewickErrorMessage(const NewickError& error, const std::string_view s);
+
+///GetNewickErrorMessage returns the description of a NewickError
+///in Newick std::vector<int> v, which is the message thrown by CheckNewick
+std::string GetNewickErrorMessage(const NewickError& error, const std::vector<int>& v);
+
+///ParseNewick converts a std::string to a Newick std::vector<int>
+///and checks if it is a valid Newick, in a single pass and without
+///throwing exceptions. If s is a valid Newick, newick becomes identical
+///to StringToNewick(s) and an error with code NewickErrorCode::none is returned.
+///Else the first error that CheckNewick would throw is returned, and
+///the content of newick is unspecified. NewickErrorCode::value_too_large
+///is returned for a valid Newick with frequencies that do not fit in an int,
+///as ValidateNewick does.
+///As s is a std::string_view, a Newick in a larger buffer
+///(e.g. a file with many Newicks) can be parsed without copying it.
+NewickError ParseNewick(const std::string_view s, std::vector<int>& newick);
+
 ///CheckNewick checks if a std::vector<int> is a valid Newick.
 ///If this std::vector<int> is not a valid Newick,
-///CheckNewick throws an exception with a detailed description
+///CheckNewick throws an exception with a detailed description.
+///Use ValidateNewick to check a Newick without exceptions
 ///From http://www.richelbilderbeek.nl/CppCheckNewick.htm
 void CheckNewick(const std::vector<int>& v);
 
 ///CheckNewick checks if a std::string is a valid Newick.
 ///If this std::string is not a valid Newick,
-///CheckNewick throws an exception with a detailed description
+///CheckNewick throws an exception with a detailed description.
+///Use ValidateNewick to check a Newick without exceptions
+///From http://www.richelbilderbeek.nl/CppCheckNewick.htm
+void CheckNewick(const std::string_view s);
+
+///CheckNewickByCuttingLeaves is the original implementation of
+///CheckNewick for a std::string: it repeatedly cuts the innermost leaf,
+///which takes quadratic time. Its results are identical to CheckNewick,
+///which does the same in a single pass.
+///From http://www.richelbilderbeek.nl/CppCheckNewick.htm
+void CheckNewickByCuttingLeaves(const std::string_view s);
+
+///CheckNewickByCuttingLeaves is the original implementation of
+///CheckNewick for a std::vector<int>: it repeatedly cuts the innermost leaf,
+///which takes quadratic time. Its results are identical to CheckNewick,
+///which does the same in a single pass.
 ///From http://www.richelbilderbeek.nl/CppCheckNewick.htm
-void CheckNewick(const std::string& s);
+void CheckNewickByCuttingLeaves(const std::vector<int>& v);
 
 ///Throws if Newick is too short to be valid
 void CheckNewickForMinimalSize(const std::vector<int>& v);
 
 ///Throws if Newick is too short to be valid
-void CheckNewickForMinimalSize(const std::string& s);
+void CheckNewickForMinimalSize(const std::string_view s);
 
 ///Throws if Newick has no opening bracket
 void CheckNewickForOpeningBracket(const std::vector<int>& v);
 
 ///Throws if Newick has no opening bracket
-void CheckNewickForOpeningBracket(const std::string& s);
+void CheckNewickForOpeningBracket(const std::string_view s);
 
 ///Throws if Newick has no closing bracket
 void CheckNewickForClosingBracket(const std::vector<int>& v);
 
 ///Throws if Newick has no closing bracket
-void CheckNewickForClosingBracket(const std::string& s);
+void CheckNewickForClosingBracket(const std::string_view s);
 
 ///Throws if Newick has an equal number of opening and closing brackets
 void CheckNewickForMatchingBrackets(const std::vector<int>& v);
 
 ///Throws if Newick has an equal number of opening and closing brackets
-void CheckNewickForMatchingBrackets(const std::string& s);
+void CheckNewickForMatchingBrackets(const std::string_view s);
 
 ///Throws if Newick has a frequency of zero
 void CheckNewickForZero(const std::vector<int>& v);
 
 ///Throws if Newick has a frequency of zero
-void CheckNewickForZero(const std::string& s);
+void CheckNewickForZero(const std::string_view s);
 
 ///Throws if Newick has no value between brackets, e.g '(1,())'
 void CheckNewickForBracketDistance(const std::vector<int>& v);
 
 ///Throws if Newick has no value between brackets, e.g '(1,())'
-void CheckNewickForBracketDistance(const std::string& s);
+void CheckNewickForBracketDistance(const std::string_view s);
 
 ///Throws if Newick has two consecutive comma's, e.g '(1,,1)'
-void CheckNewickForConsecutiveCommas(const std::string& s);
+void CheckNewickForConsecutiveCommas(const std::string_view s);
 
 ///Throws if Newick has a comma after a bracket open, e.g '(,1)'
-void CheckNewickForCommaAfterBracketOpen(const std::string& s);
+void CheckNewickForCommaAfterBracketOpen(const std::string_view s);
 
 ///Throws if Newick has a comma before a bracket close, e.g '(1,)'
-void CheckNewickForCommaBeforeBracketClose(const std::string& s);
+void CheckNewickForCommaBeforeBracketClose(const std::string_view s);
 
 ///CreateValidBinaryNewicks creates std::strings
 ///that can be converted to a BinaryNewickVector.
@@ -321,7 +439,7 @@ std::vector<T> CreateVector(const T& a, const T& b, const T& c)
 ///(1,(1,1))
 ///   ^   ^
 std::pair<std::size_t, std::size_t> FindOpeningAndClosingBracketIndices(
-  const std::string& s
+  const std::string_view s
 );
 
 ///Finds the indices of the innermost brackets
@@ -332,12 +450,21 @@ std::pair<std::size_t, std::size_t> FindOpeningAndClosingBracketIndices(
   const std::vector<int>& v
 );
 
+///FindOpeningAndClosingBracketIndices using the NewickIndex of
+///valid Newick v, which follows the first subtree down to a leaf
+///instead of scanning v
+std::pair<std::size_t, std::size_t> FindOpeningAndClosingBracketIndices(
+  const std::vector<int>& v,
+  const NewickIndex& index
+) noexcept;
+
 
 ///GetSimplerNewicks creates simpler, derived Newicks from a Newick.
 ///From http://www.richelbilderbeek.nl/CppGetSimplerNewicks.htm
 std::vector<std::vector<int>> GetSimplerNewicks(
   const std::vector<int>& n
 ) noexcept;
+std::vector<ValidatedNewick> GetSimplerNewicks(const ValidatedNewick& n);
 
 ///Used by GetSimplerNewicks
 std::vector<std::vector<int>> GetSimplerNewicksEasy(
@@ -352,6 +479,28 @@ std::vector<std::pair<std::vector<int>,int> >
   const std::vector<int>& n
 );
 
+///GetSimplerNewicksFrequencyPairs writes the simpler Newicks and their frequencies
+///to newicks, reusing its elements and their capacities.
+///Allocates one buffer for writing the simpler Newicks per call, which the
+///overload below takes from the caller instead, and only allocates more memory
+///if newicks is too small, which it is not if it has been used for a Newick
+///that is at least as big
+void GetSimplerNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<std::pair<std::vector<int>,int>>& newicks
+);
+
+///GetSimplerNewicksFrequencyPairs writes the simpler Newicks and their frequencies
+///to newicks, writing each simpler Newick to buffer first,
+///as VisitSimplerNewicksFrequencyPairs does. Does not allocate memory if newicks
+///is big enough and the capacity of buffer is at least the size of n,
+///so both can be reused over the Newicks of a calculation
+void GetSimplerNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<std::pair<std::vector<int>,int>>& newicks,
+  std::vector<int>& buffer
+);
+
 ///Used by GetSimplerNewicks
 std::vector<std::vector<int>> GetSimplerNewicksHard(
   const std::vector<int>& n
@@ -363,11 +512,19 @@ std::vector<std::vector<int>> GetSimplerNewicksHardFromHere(
   const int i
 ) noexcept;
 
+///GetSimplerNewicksHardFromHere using the NewickIndex of Newick n,
+///which visits the siblings of the frequency at index i only
+std::vector<std::vector<int>> GetSimplerNewicksHardFromHere(
+  const std::vector<int>& n,
+  const int i,
+  const NewickIndex& index
+) noexcept;
+
 
 ///IsNewick returns true if a std::string is a valid Newick
 ///and false otherwise.
 ///From http://www.richelbilderbeek.nl/CppIsNewick.htm
-bool IsNewick(const std::string& s) noexcept;
+bool IsNewick(const std::string_view s) noexcept;
 
 ///IsNewick returns true if a std::vector<int> is a valid Newick
 ///and false otherwise.
@@ -390,71 +547,252 @@ std::vector<int> Surround(const std::vector<int>& newick) noexcept;
 ///Surround surrounds the frequency with brackets
 std::vector<int> Surround(const int f) noexcept;
 
+///ValidateNewick checks if a std::string is a valid Newick,
+///without throwing an exception. Returns the first error that
+///CheckNewick would throw, or an error with code NewickErrorCode::none
+///if the Newick is valid.
+///Takes linear time and memory linear to the depth of the Newick
+NewickError ValidateNewick(const std::string_view s) noexcept;
+
+///ValidateNewick checks if a std::vector<int> is a valid Newick,
+///without throwing an exception. Returns the first error that
+///CheckNewick would throw, or an error with code NewickErrorCode::none
+///if the Newick is valid.
+///Takes linear time and does not allocate memory
+NewickError ValidateNewick(const std::vector<int>& v) noexcept;
+
+///VisitSimplerNewicksFrequencyPairs calls f(simpler_newick, frequency) for each
+///simpler Newick of n and its frequency, in the order of GetSimplerNewicksFrequencyPairs.
+///Each simpler Newick is written to buffer, which f must copy to keep.
+///Does not allocate memory if the capacity of buffer is at least the size of n
+template <class Function>
+void VisitSimplerNewicksFrequencyPairs(
+  const std::vector<int>& n,
+  std::vector<int>& buffer,
+  Function f
+)
+{
+  assert(IsNewick(n));
+  const int size = static_cast<int>(n.size());
+  for (int i=0; i!=size; ++i)
+  {
+    if (n[i] < 1) continue;
+    if (n[i] > 1)
+    {
+      buffer.assign(std::begin(n), std::end(n));
+      --buffer[i];
+      f(static_cast<const std::vector<int>&>(buffer), n[i]);
+      continue;
+    }
+    //Add the 1 to a sibling frequency at index j
+    const auto add_to = [&n, &buffer, &f, i, size](const int j)
+    {
+      //If the 1 is added to its only sibling, remove both brackets,
+      //unless these are the outer brackets: '((1,1),2)' -> '(2,2)'
+      const int first = std::min(i,j);
+      const int last = std::max(i,j);
+      const bool remove_brackets = last - first == 1
+        && n[first - 1] == bracket_open && n[last + 1] == bracket_close
+        && (first - 1 != 0 || last + 1 != size - 1);
+      buffer.clear();
+      for (int k=0; k!=size; ++k)
+      {
+        if (k == i || (remove_brackets && (k == first - 1 || k == last + 1))) continue;
+        buffer.push_back(k == j ? n[k] + 1 : n[k]);
+      }
+      assert(IsNewick(buffer));
+      f(static_cast<const std::vector<int>&>(buffer), 1);
+    };
+    //The siblings before i, nearest first, skipping the subtrees between these
+    for (int j=i-1, depth=0; ; --j)
+    {
+      if (n[j] == bracket_close) { ++depth; continue; }
+      if (n[j] == bracket_open) { if (depth == 0) break; --depth; continue; }
+      if (depth == 0) add_to(j);
+    }
+    //The siblings after i
+    for (int j=i+1, depth=0; ; ++j)
+    {
+      if (n[j] == bracket_open) { ++depth; continue; }
+      if (n[j] == bracket_close) { if (depth == 0) break; --depth; continue; }
+      if (depth == 0) add_to(j);
+    }
+  }
+}
+
+///UnaryArityPolicy, BinaryArityPolicy and GeneralArityPolicy select at compile time
+///the kernel with which CalculateProbability creates simpler Newicks.
+///Fits checks if a Newick has the arity of the policy.
+///The kernel writes to buffer, and may use newick_buffer to write a
+///std::vector<int> Newick to first; both are reused by the caller.
+///A unary Newick, such as '(3)', is simple, so it has no simpler Newicks to create
+struct UnaryArityPolicy
+{
+  template <class T>
+  static bool Fits(const T& n) { return IsUnaryNewick(n); }
+
+  template <class T, class Buffer>
+  static void GetSimplerNewicks(const T&, Buffer& buffer, std::vector<int>&)
+  {
+    assert(!"A unary Newick is simple"); //!OCLINT accepted idiom
+    buffer.clear();
+  }
+};
+
+///The kernel of a binary Newick only adds a frequency of one to its neighbour
+struct BinaryArityPolicy
+{
+  template <class T>
+  static bool Fits(const T& n) { return IsBinaryNewick(n); }
+
+  template <class T, class Buffer>
+  static void GetSimplerNewicks(const T& n, Buffer& buffer, std::vector<int>&)
+  {
+    GetSimplerBinaryNewicksFrequencyPairs(n, buffer);
+  }
+};
+
+///The kernel of any Newick, used for trinary and other Newicks
+struct GeneralArityPolicy
+{
+  template <class T>
+  static bool Fits(const T&) { return true; }
+
+  template <class T, class Buffer>
+  static void GetSimplerNewicks(const T& n, Buffer& buffer, std::vector<int>&)
+  {
+    GetSimplerNewicksFrequencyPairs(n, buffer);
+  }
+
+  static void GetSimplerNewicks(
+    const std::vector<int>& n,
+    std::vector<std::pair<std::vector<int>,int>>& buffer,
+    std::vector<int>& newick_buffer
+  )
+  {
+    GetSimplerNewicksFrequencyPairs(n, buffer, newick_buffer);
+  }
+};
+
+///Used by CalculateProbability, for a theta of type double
+template <class NewickType>
+double CalcDenominatorOf(const NewickType& n, const double theta) noexcept
+{
+  return n.CalcDenominator(theta);
+}
+
+///Used by CalculateProbability, for a theta of type double
 template <class NewickType>
-double CalculateProbability(
+double CalcProbabilitySimpleNewickOf(const NewickType& n, const double theta) noexcept
+{
+  return n.CalcProbabilitySimpleNewick(theta);
+}
+
+///Used by CalculateProbability, n must be canonical.
+///Its simpler Newicks are made canonical before being stored or looked up.
+///The simpler Newicks of n are written to buffer, which is reused by all
+///Newicks as is newick_buffer, so that only the simpler Newicks not in
+///storage are copied.
+///Instead of recursing per Newick, the Newicks of which the simpler Newicks
+///are being summed are kept on an explicit stack, so that the depth of the
+///calculation is limited by the heap instead of by the call stack.
+///If memory runs out, storage is cleaned up and the calculation restarts
+///from n, finding the probabilities that are still stored
+template <class ArityPolicy, class NewickType, class Map, class Buffer>
+typename Map::mapped_type CalculateProbabilityOfCanonical(
   const NewickType& n,
-  const double theta,
-  NewickStorage<NewickType>& storage
+  const typename Map::mapped_type& theta,
+  NewickStorage<NewickType, Map>& storage,
+  Buffer& buffer,
+  std::vector<int>& newick_buffer
 )
 {
+  typedef typename Map::mapped_type Probability;
+  //A Newick of which the probabilities of the simpler Newicks are being summed
+  struct Frame
+  {
+    NewickType newick;
+    ///The sum of the simpler Newicks done
+    Probability p;
+    ///The simpler Newicks in pending are at [begin,end),
+    ///of which those at [next,end) are not done yet
+    std::size_t begin;
+    std::size_t next;
+    std::size_t end;
+  };
   while(1)
   {
     try
     {
-      //Is n already known?
+      std::vector<Frame> frames;
+      //The simpler Newicks not known when their Newick was expanded,
+      //and their coefficients, those of each frame after those of its parent
+      std::vector<std::pair<NewickType, Probability>> pending;
+
+      //If the probability of m is known or m is simple, sets p to it.
+      //Else pushes a frame for m with the sum of its known simpler Newicks
+      //and its other simpler Newicks pending
+      const auto expand = [&theta, &storage, &buffer, &newick_buffer, &frames, &pending](
+        const NewickType& m, Probability& p)
       {
-        const double p = storage.Find(n);
-        if (p!=0.0)
+        p = storage.Find(m);
+        if (p != Probability()) return true;
+        if (m.IsSimple())
         {
-          return p;
+          p = CalcProbabilitySimpleNewickOf(m, theta);
+          storage.Store(m,p);
+          return true;
         }
-      }
-
-      //Check for simple phylogeny
-      if (n.IsSimple())
-      {
-        const double p = n.CalcProbabilitySimpleNewick(theta);
-        storage.Store(n,p);
-        return p;
-      }
-      //Complex
-      //Generate other Newicks and their coefficients
-      std::vector<double> coefficients;
-      std::vector<NewickType> newicks;
-      {
-        const double d = n.CalcDenominator(theta);
-        typedef std::pair<std::vector<int>,int> NewickFrequencyPair;
-        const std::vector<NewickFrequencyPair> newick_freqs
-          = GetSimplerNewicksFrequencyPairs(n.Peek());
-        for(const NewickFrequencyPair& p: newick_freqs)
+        //m may be in pending, so it is copied before pending grows
+        frames.push_back(Frame{m, Probability(), pending.size(), pending.size(), pending.size()});
+        Frame& frame = frames.back();
+        const Probability d = CalcDenominatorOf(frame.newick, theta);
+        //Peek need not return a std::vector<int>, as long as
+        //there is a GetSimplerNewicksFrequencyPairs overload for it
+        ArityPolicy::GetSimplerNewicks(frame.newick.Peek(), buffer, newick_buffer);
+        for(const auto& q: buffer)
         {
-          const int frequency = p.second;
+          const int frequency = q.second;
           assert(frequency > 0);
-          if (frequency == 1)
+          const double f_d = static_cast<double>(frequency);
+          const Probability coefficient = frequency == 1 ? theta / d : (f_d*(f_d-1.0)) / d;
+          NewickType newick(GetCanonicalNewick(q.first));
+          const Probability p_known = storage.Find(newick);
+          if (p_known != Probability())
           {
-            newicks.push_back(p.first);
-            coefficients.push_back(theta / d);
-          }
-          else
-          {
-            const double f_d = static_cast<double>(frequency);
-            newicks.push_back(p.first);
-            coefficients.push_back( (f_d*(f_d-1.0)) / d);
+            frame.p += coefficient * p_known;
+            continue;
           }
+          pending.push_back(std::make_pair(std::move(newick), coefficient));
         }
-      }
-      //Ask help about these new Newicks
+        frame.end = pending.size();
+        return false;
+      };
+
+      Probability p = Probability();
+      if (expand(n, p)) return p;
+      while (1)
       {
-        const int sz = newicks.size();
-        assert(newicks.size() == coefficients.size() );
-        double p = 0.0;
-        for (int i=0; i!=sz; ++i)
+        const std::size_t i = frames.size() - 1;
+        if (frames[i].next == frames[i].end)
+        {
+          //All simpler Newicks are summed
+          p = frames[i].p;
+          storage.Store(frames[i].newick, p);
+          pending.erase(std::begin(pending) + frames[i].begin, std::end(pending));
+          frames.pop_back();
+          if (frames.empty()) return p;
+          Frame& parent = frames.back();
+          parent.p += pending[parent.next].second * p;
+          ++parent.next;
+          continue;
+        }
+        //The next simpler Newick, which may have been calculated since
+        if (expand(pending[frames[i].next].first, p))
         {
-          //Recursive function call
-          p+=(coefficients[i] * CalculateProbability(newicks[i],theta,storage));
+          frames[i].p += pending[frames[i].next].second * p;
+          ++frames[i].next;
         }
-        storage.Store(n,p);
-        return p;
       }
     }
     catch (std::bad_alloc& e)
@@ -462,17 +800,240 @@ double CalculateProbability(
       storage.CleanUp();
       std::cerr << "std::bad_alloc\n";
     }
-    catch (std::exception& e)
+  }
+}
+
+///CalculateProbabilityByArity calculates the probability of a Newick for
+///a value of theta, creating the simpler Newicks with the kernel of
+///ArityPolicy, which must fit the arity of n
+template <class ArityPolicy, class NewickType, class Map>
+typename Map::mapped_type CalculateProbabilityByArity(
+  const NewickType& n,
+  const typename Map::mapped_type& theta,
+  NewickStorage<NewickType, Map>& storage
+)
+{
+  assert(ArityPolicy::Fits(n.Peek()));
+  decltype(GetSimplerNewicksFrequencyPairs(n.Peek())) buffer;
+  std::vector<int> newick_buffer;
+  return CalculateProbabilityOfCanonical<ArityPolicy>(
+    NewickType(GetCanonicalNewick(n.Peek())), theta, storage, buffer, newick_buffer
+  );
+}
+
+///CalculateProbability calculates the probability of a Newick for a value of theta.
+///Newicks that only differ in the order of siblings have the same probability,
+///so only canonical Newicks (see GetCanonicalNewick) are stored.
+///The simpler Newicks of a unary or binary Newick that are not simple are binary,
+///so the kernel to create these is chosen once, from the arity of n.
+///The probability has the type of those in the storage, which is a double
+///by default, or a DualNumber to calculate its derivatives with respect to theta
+template <class NewickType, class Map>
+typename Map::mapped_type CalculateProbability(
+  const NewickType& n,
+  const typename Map::mapped_type& theta,
+  NewickStorage<NewickType, Map>& storage
+)
+{
+  if (UnaryArityPolicy::Fits(n.Peek()))
+  {
+    return CalculateProbabilityByArity<UnaryArityPolicy>(n, theta, storage);
+  }
+  if (BinaryArityPolicy::Fits(n.Peek()))
+  {
+    return CalculateProbabilityByArity<BinaryArityPolicy>(n, theta, storage);
+  }
+  return CalculateProbabilityByArity<GeneralArityPolicy>(n, theta, storage);
+}
+
+///Used by CalculateProbabilityByLevels
+template <class ArityPolicy, class Map, class NewickType>
+double CalculateProbabilityByLevelsAndArity(
+  const NewickType& n,
+  const double theta,
+  int& max_n_newicks
+)
+{
+  //P(n) is the sum over all simple Newicks s that can be derived from n
+  //of w(s) * P(s), in which the weight w(s) is the sum over all paths from n to s
+  //of the product of their coefficients. The weights are pushed from n down.
+  //A simpler Newick has a lower sum of frequencies, or the same sum (if a
+  //frequency of one is added to a sibling, which is given a frequency of one)
+  //and a lower Size. A level holds the Newicks with the same sum, per Size,
+  //of which the bigger Newicks are done first. A level is freed as soon as it
+  //is done, so only two levels are kept in memory
+  std::vector<Map> level(n.Size() + 1);
+  std::vector<Map> next_level(n.Size() + 1);
+  const NewickType root(GetCanonicalNewick(n.Peek()));
+  level[root.Size()][root] = 1.0;
+  decltype(GetSimplerNewicksFrequencyPairs(n.Peek())) buffer;
+  std::vector<int> newick_buffer;
+  double p = 0.0;
+  max_n_newicks = 0;
+  while (1)
+  {
+    int n_newicks = 0;
+    for (const auto& m: level) n_newicks += m.size();
+    for (const auto& m: next_level) n_newicks += m.size();
+    if (n_newicks == 0) return p;
+    max_n_newicks = std::max(max_n_newicks, n_newicks);
+    for (int size = n.Size(); size != 0; --size)
     {
-      storage.CleanUp();
-      std::cerr << "std::exception";
+      for (const auto& q: level[size])
+      {
+        const NewickType& m = q.first;
+        const double w = q.second;
+        if (m.IsSimple())
+        {
+          p += w * m.CalcProbabilitySimpleNewick(theta);
+          continue;
+        }
+        const double d = m.CalcDenominator(theta);
+        ArityPolicy::GetSimplerNewicks(m.Peek(), buffer, newick_buffer);
+        for(const auto& r: buffer)
+        {
+          const int frequency = r.second;
+          assert(frequency > 0);
+          const double f_d = static_cast<double>(frequency);
+          const double coefficient = frequency == 1 ? theta / d : (f_d*(f_d-1.0)) / d;
+          NewickType newick(GetCanonicalNewick(r.first));
+          assert(frequency > 1 || newick.Size() < size);
+          (frequency == 1 ? level : next_level)[newick.Size()][newick] += w * coefficient;
+        }
+      }
+      level[size] = Map();
+    }
+    std::swap(level, next_level);
+  }
+}
+
+///CalculateProbabilityByLevels calculates the same probability as CalculateProbability,
+///without storing all Newicks that can be derived from n: only those of two
+///sums of frequencies are kept, so that memory depends on the widest level
+///instead of on all derived Newicks. max_n_newicks is set to the most Newicks
+///kept at once. Map maps a Newick to a double, as in NewickStorage
+template <class NewickType, class Map = std::map<NewickType,double>>
+double CalculateProbabilityByLevels(
+  const NewickType& n,
+  const double theta,
+  int& max_n_newicks
+)
+{
+  if (BinaryArityPolicy::Fits(n.Peek()))
+  {
+    return CalculateProbabilityByLevelsAndArity<BinaryArityPolicy, Map>(n, theta, max_n_newicks);
+  }
+  return CalculateProbabilityByLevelsAndArity<GeneralArityPolicy, Map>(n, theta, max_n_newicks);
+}
+
+///CalculateProbabilityByLevels calculates the same probability as CalculateProbability,
+///keeping only the Newicks of two sums of frequencies in memory
+template <class NewickType, class Map = std::map<NewickType,double>>
+double CalculateProbabilityByLevels(
+  const NewickType& n,
+  const double theta
+)
+{
+  int max_n_newicks = 0;
+  return CalculateProbabilityByLevels<NewickType, Map>(n, theta, max_n_newicks);
+}
+
+///Used by CalculateProbabilities
+template <class ArityPolicy, class Map, class NewickType>
+std::vector<double> CalculateProbabilitiesAndArity(
+  const NewickType& n,
+  const std::vector<double>& thetas
+)
+{
+  //As CalculateProbabilityByLevels, except that each Newick has a weight per theta.
+  //A level maps each Newick to its index in the weights, which are stored
+  //contiguously per Newick, so that each theta is a lane of the same loop,
+  //which uses AVX2 if the CPU supports it
+  const int n_thetas = static_cast<int>(thetas.size());
+  if (n_thetas == 0) return {};
+  std::vector<Map> level(n.Size() + 1);
+  std::vector<Map> next_level(n.Size() + 1);
+  std::vector<double> weights(n_thetas, 1.0);
+  std::vector<double> next_weights;
+  const NewickType root(GetCanonicalNewick(n.Peek()));
+  level[root.Size()][root] = 0;
+  decltype(GetSimplerNewicksFrequencyPairs(n.Peek())) buffer;
+  std::vector<int> newick_buffer;
+  std::vector<double> ps(n_thetas, 0.0);
+  std::vector<double> ws(n_thetas, 0.0);
+  const SimdLevel simd_level = GetSimdLevel();
+  //Adds ws times theta (for a frequency of one) or f*(f-1) to the weights of a Newick
+  const auto add_to = [&](Map& m, std::vector<double>& v, const NewickType& newick, const int frequency)
+  {
+    const auto q = m.insert(std::make_pair(newick, static_cast<int>(v.size()) / n_thetas));
+    if (q.second) v.resize(v.size() + n_thetas, 0.0);
+    double * const w = v.data() + q.first->second * n_thetas;
+    if (frequency == 1)
+    {
+      AddLaneProducts(w, ws.data(), thetas.data(), n_thetas, simd_level);
+      return;
     }
-    catch (...)
+    const double f_d = static_cast<double>(frequency);
+    AddLaneMultiples(w, ws.data(), f_d * (f_d - 1.0), n_thetas, simd_level);
+  };
+  while (1)
+  {
+    if (weights.empty()) return ps;
+    for (int size = n.Size(); size != 0; --size)
     {
-      storage.CleanUp();
-      std::cerr << "Unknown exception\n";
+      for (const auto& q: level[size])
+      {
+        const NewickType& m = q.first;
+        const double * const w = weights.data() + q.second * n_thetas;
+        if (m.IsSimple())
+        {
+          for (int i=0; i!=n_thetas; ++i) ps[i] += w[i] * m.CalcProbabilitySimpleNewick(thetas[i]);
+          continue;
+        }
+        //The denominator is linear in theta
+        const double d_0 = m.CalcDenominator(0.0);
+        const double d_1 = m.CalcDenominator(1.0) - d_0;
+        DivideLanesByDenominators(w, d_0, d_1, thetas.data(), ws.data(), n_thetas, simd_level);
+        ArityPolicy::GetSimplerNewicks(m.Peek(), buffer, newick_buffer);
+        for(const auto& r: buffer)
+        {
+          assert(r.second > 0);
+          NewickType newick(GetCanonicalNewick(r.first));
+          assert(r.second > 1 || newick.Size() < size);
+          if (r.second == 1)
+          {
+            add_to(level[newick.Size()], weights, newick, r.second);
+          }
+          else
+          {
+            add_to(next_level[newick.Size()], next_weights, newick, r.second);
+          }
+        }
+      }
+      level[size] = Map();
     }
+    std::swap(level, next_level);
+    std::swap(weights, next_weights);
+    next_weights.clear();
+  }
+}
+
+///CalculateProbabilities calculates the probability of a Newick for each theta,
+///as CalculateProbability does for one theta, in a single traversal of the
+///Newicks that can be derived from it. As CalculateProbabilityByLevels, it
+///keeps only the Newicks of two sums of frequencies in memory.
+///Map maps a Newick to an int
+template <class NewickType, class Map = std::map<NewickType,int>>
+std::vector<double> CalculateProbabilities(
+  const NewickType& n,
+  const std::vector<double>& thetas
+)
+{
+  if (BinaryArityPolicy::Fits(n.Peek()))
+  {
+    return CalculateProbabilitiesAndArity<BinaryArityPolicy, Map>(n, thetas);
   }
+  return CalculateProbabilitiesAndArity<GeneralArityPolicy, Map>(n, thetas);
 }
 
 } //~namespace newick
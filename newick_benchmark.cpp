@@ -0,0 +1,797 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "compactnewick.h"
+#include "dualnumber.h"
+#include "newick.h"
+#include "newickcorpus.h"
+#include "newickhash.h"
+#include "newickparallel.h"
+#include "newickprobabilityplan.h"
+#include "newickrationalfunction.h"
+#include "persistentnewick.h"
+#include "smallnewick.h"
+
+namespace {
+
+///The number of bytes allocated by a CountingAllocator
+std::size_t n_bytes_allocated = 0;
+
+///CountingAllocator is a std::allocator that counts the bytes it allocates
+template <class T>
+struct CountingAllocator : public std::allocator<T>
+{
+  typedef T value_type;
+  template <class U> struct rebind { typedef CountingAllocator<U> other; };
+  CountingAllocator() noexcept {}
+  template <class U> CountingAllocator(const CountingAllocator<U>&) noexcept {}
+  T * allocate(const std::size_t n)
+  {
+    n_bytes_allocated += n * sizeof(T);
+    return std::allocator<T>::allocate(n);
+  }
+};
+
+///The number of calls to the global operator new
+std::size_t n_allocations = 0;
+
+} //~namespace
+
+//The global operator new is replaced to count the allocations made within
+//the library as well, which a counting allocator cannot see.
+//Because the replacements use std::malloc and std::free, GCC sees std::free
+//called on memory from operator new when it inlines a delete at -O3,
+//and warns of a mismatch that does not exist
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void * operator new(const std::size_t n)
+{
+  ++n_allocations;
+  if (void * const p = std::malloc(n)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void * const p) noexcept { std::free(p); }
+void operator delete(void * const p, const std::size_t) noexcept { std::free(p); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+///Measure the time in seconds it takes to call f n times
+double MeasureTime(const std::function<void()>& f, const int n)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (int i=0; i!=n; ++i) { f(); }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+///Compare CheckNewick with its original CheckNewickByCuttingLeaves
+///on random binary Newicks of increasing size
+void BenchmarkCheckNewick()
+{
+  using namespace ribi::newick;
+  std::cout << "CheckNewick versus CheckNewickByCuttingLeaves\n"
+    << "n_leaves\tn_chars\tt_single_pass (s)\tt_cutting_leaves (s)\n";
+  for (const int n_leaves: { 10, 100, 1000, 10000 })
+  {
+    const std::string s = CreateRandomNewick(n_leaves, 1000);
+    const int n_repeats = 1000000 / (n_leaves * n_leaves) + 1;
+    const double t_fast = MeasureTime([s]() { CheckNewick(s); }, n_repeats);
+    const double t_slow = MeasureTime([s]() { CheckNewickByCuttingLeaves(s); }, n_repeats);
+    std::cout << n_leaves << '\t' << s.size() << '\t'
+      << (t_fast / n_repeats) << '\t' << (t_slow / n_repeats) << '\n';
+  }
+}
+
+///Compare CheckNewick with its original CheckNewickByCuttingLeaves
+///on random binary Newick std::vector<int>s of increasing size
+void BenchmarkCheckNewickVector()
+{
+  using namespace ribi::newick;
+  std::cout << "CheckNewick versus CheckNewickByCuttingLeaves on std::vector<int>\n"
+    << "n_leaves\tn_values\tt_single_pass (s)\tt_cutting_leaves (s)\n";
+  for (const int n_leaves: { 10, 100, 1000, 10000 })
+  {
+    const std::vector<int> v = CreateRandomBinaryNewickVector(n_leaves, 1000);
+    const int n_repeats = 1000000 / (n_leaves * n_leaves) + 1;
+    const double t_fast = MeasureTime([v]() { CheckNewick(v); }, n_repeats);
+    const double t_slow = MeasureTime([v]() { CheckNewickByCuttingLeaves(v); }, n_repeats);
+    std::cout << n_leaves << '\t' << v.size() << '\t'
+      << (t_fast / n_repeats) << '\t' << (t_slow / n_repeats) << '\n';
+  }
+}
+
+///Compare IsNewick followed by StringToNewick with ParseNewick
+///on many small random Newicks
+void BenchmarkParseNewick()
+{
+  using namespace ribi::newick;
+  std::vector<std::string> newicks;
+  for (int i=0; i!=10000; ++i)
+  {
+    newicks.push_back(CreateRandomNewick(2 + (i % 20), 1000));
+  }
+  const int n_repeats = 10;
+  const double t_two_passes = MeasureTime(
+    [newicks]()
+    {
+      for (const std::string& s: newicks)
+      {
+        if (IsNewick(s)) StringToNewick(s);
+      }
+    }, n_repeats
+  );
+  const double t_fused = MeasureTime(
+    [newicks]()
+    {
+      std::vector<int> v;
+      for (const std::string& s: newicks)
+      {
+        ParseNewick(s, v);
+      }
+    }, n_repeats
+  );
+  std::cout << "IsNewick and StringToNewick versus ParseNewick\n"
+    << "n_newicks\tt_two_passes (s)\tt_fused (s)\n"
+    << newicks.size() << '\t' << (t_two_passes / n_repeats)
+    << '\t' << (t_fused / n_repeats) << '\n';
+}
+
+///Compare detecting invalid Newicks by catching the exception
+///thrown by CheckNewick with ValidateNewick
+void BenchmarkValidateNewick()
+{
+  using namespace ribi::newick;
+  const std::vector<std::string> newicks = CreateInvalidNewicks();
+  const int n_repeats = 10000;
+  const double t_exception = MeasureTime(
+    [newicks]()
+    {
+      for (const std::string& s: newicks)
+      {
+        try { CheckNewick(s); } catch (const std::invalid_argument&) {}
+      }
+    }, n_repeats
+  );
+  const double t_error_code = MeasureTime(
+    [newicks]()
+    {
+      for (const std::string& s: newicks)
+      {
+        ValidateNewick(s);
+      }
+    }, n_repeats
+  );
+  const double n_newicks = static_cast<double>(n_repeats * newicks.size());
+  std::cout << "Invalid Newicks per second, CheckNewick versus ValidateNewick\n"
+    << "n_newicks\tCheckNewick (1/s)\tValidateNewick (1/s)\n"
+    << n_newicks << '\t' << (n_newicks / t_exception)
+    << '\t' << (n_newicks / t_error_code) << '\n';
+}
+
+///Compare reading a file with many Newicks line by line with
+///NewickCorpus, both sequentially and in parallel
+void BenchmarkNewickCorpus()
+{
+  using namespace ribi::newick;
+  const std::string filename{"newick_benchmark_corpus.txt"};
+  const int n_newicks = 100000;
+  {
+    std::ofstream f(filename);
+    for (int i=0; i!=n_newicks; ++i) { f << CreateRandomNewick(20, 100) << '\n'; }
+  }
+  const double t_getline = MeasureTime(
+    [filename]()
+    {
+      std::ifstream f(filename);
+      std::vector<int> v;
+      for (std::string s; std::getline(f, s); ) { ParseNewick(s, v); }
+    }, 1
+  );
+  const ribi::NewickCorpus corpus(filename);
+  const double t_for_each = MeasureTime(
+    [&corpus]()
+    {
+      corpus.ForEach(
+        [](const std::string_view, const std::vector<int>&, const NewickError&) {}
+      );
+    }, 1
+  );
+  const double t_parse_all = MeasureTime([&corpus]() { corpus.ParseAll(); }, 1);
+  std::cout << "Reading " << n_newicks << " Newicks of 20 leaves\n"
+    << "t_getline (s)\tt_for_each (s)\tt_parse_all (s)\n"
+    << t_getline << '\t' << t_for_each << '\t' << t_parse_all << '\n';
+  std::remove(filename.c_str());
+}
+
+///Compare GetDepth with GetDepthParallel on a huge Newick
+void BenchmarkGetDepthParallel()
+{
+  using namespace ribi::newick;
+  const std::vector<int> v = StringToNewick(CreateRandomNewick(1000000, 1000));
+  std::cout << "GetDepth versus GetDepthParallel on " << v.size() << " elements\n"
+    << "n_threads\tt (s)\n";
+  std::cout << "sequential\t" << MeasureTime([&v]() { GetDepth(v); }, 10) / 10 << '\n';
+  for (const int n_threads: { 1, 2, 4, 8 })
+  {
+    const double t = MeasureTime([&v, n_threads]() { GetDepthParallel(v, n_threads); }, 10);
+    std::cout << n_threads << '\t' << (t / 10) << '\n';
+  }
+}
+
+///Measure the bytes allocated to store all Newicks that
+///can be derived from a Newick in a std::map, keyed on either
+///a std::vector<int> or a CompactNewick
+void BenchmarkCompactNewick()
+{
+  using namespace ribi::newick;
+  std::cout << "Memory use of std::map keyed on std::vector<int> versus CompactNewick\n"
+    << "newick\tn_newicks\tvector (bytes)\tCompactNewick (bytes)\n";
+  for (const std::string s: { "((20,20),20)", "((100,10),10)", "(((10,10),10),10)" })
+  {
+    //All Newicks that can be derived from s
+    std::set<std::vector<int>> newicks;
+    std::vector<std::vector<int>> todo{StringToNewick(s)};
+    while (!todo.empty())
+    {
+      const std::vector<int> v = todo.back();
+      todo.pop_back();
+      if (!newicks.insert(v).second) continue;
+      for (const auto& w: GetSimplerNewicks(v)) todo.push_back(w);
+    }
+    const std::vector<CompactNewick> compact_newicks(newicks.begin(), newicks.end());
+
+    //The bytes of the std::map nodes and the bytes of the keys on the heap
+    n_bytes_allocated = 0;
+    std::map<std::vector<int>, double, std::less<std::vector<int>>,
+      CountingAllocator<std::pair<const std::vector<int>, double>>> m;
+    std::size_t n_bytes_vector = 0;
+    for (const auto& v: newicks)
+    {
+      m.insert(std::make_pair(v, 0.0));
+      n_bytes_vector += v.size() * sizeof(int);
+    }
+    n_bytes_vector += n_bytes_allocated;
+
+    n_bytes_allocated = 0;
+    std::map<CompactNewick, double, std::less<CompactNewick>,
+      CountingAllocator<std::pair<const CompactNewick, double>>> n;
+    std::size_t n_bytes_compact = 0;
+    for (const auto& c: compact_newicks)
+    {
+      n.insert(std::make_pair(c, 0.0));
+      n_bytes_compact += c.GetHeapMemoryUse();
+    }
+    n_bytes_compact += n_bytes_allocated;
+
+    std::cout << s << '\t' << newicks.size() << '\t'
+      << n_bytes_vector << '\t' << n_bytes_compact << '\n';
+  }
+}
+
+///Count the heap allocations made by GetSimplerNewicksFrequencyPairs
+///for all Newicks that can be derived from a Newick, on either
+///a std::vector<int> or a SmallNewick
+void BenchmarkSmallNewick()
+{
+  using namespace ribi::newick;
+  std::cout << "Heap allocations of GetSimplerNewicksFrequencyPairs "
+    << "on std::vector<int> versus SmallNewick\n"
+    << "newick\tn_newicks\tvector (allocations)\tSmallNewick (allocations)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((1,2),(3,(4,5)),(6,7))" })
+  {
+    //All Newicks that can be derived from s
+    std::set<std::vector<int>> newicks;
+    std::vector<std::vector<int>> todo{StringToNewick(s)};
+    while (!todo.empty())
+    {
+      const std::vector<int> v = todo.back();
+      todo.pop_back();
+      if (!newicks.insert(v).second) continue;
+      for (const auto& w: GetSimplerNewicks(v)) todo.push_back(w);
+    }
+    const std::vector<SmallNewick> small_newicks(newicks.begin(), newicks.end());
+
+    n_allocations = 0;
+    for (const auto& v: newicks) GetSimplerNewicksFrequencyPairs(v);
+    const std::size_t n_allocations_vector = n_allocations;
+
+    n_allocations = 0;
+    for (const auto& n: small_newicks) GetSimplerNewicksFrequencyPairs(n);
+    const std::size_t n_allocations_small = n_allocations;
+
+    std::cout << s << '\t' << newicks.size() << '\t'
+      << n_allocations_vector << '\t' << n_allocations_small << '\n';
+  }
+}
+
+///The first of GetHardBiologicalBinaryNewicks, in newickdemodialog.cpp
+std::vector<std::string> GetHardBiologicalNewicks()
+{
+  return {
+    "((1,(1,(((((1,(1,((1,1),(3,1)))),1),((((1,((1,((1,1),(45,6))),(((1,1),(4,1)),2))),1),2),1)),1),2))),(1,1))",
+    "((1,(1,(((((1,(1,(2,2))),1),((((1,((1,(1,(35,7))),((4,4),1))),1),4),1)),1),1))),((1,(1,1)),1))",
+    "((1,(1,((((((2,1),(1,((1,1),1))),1),((((1,((1,(5,(36,10))),((2,2),1))),1),(1,5)),1)),1),1))),(1,1))"
+  };
+}
+
+///Count the Newicks that CalculateProbability would store and
+///find in its NewickStorage, for the first levels of simpler Newicks
+///of hard biological Newicks, with and without sorting the siblings
+///of each Newick (see GetCanonicalNewick)
+void BenchmarkCanonicalNewick()
+{
+  using namespace ribi::newick;
+  const std::vector<std::string> hard_newicks{GetHardBiologicalNewicks()};
+  const int n_levels = 5;
+  std::cout << "Newicks stored and found in the first " << n_levels
+    << " levels of simpler Newicks, without versus with GetCanonicalNewick\n"
+    << "newick\tn_stored\tn_found\tn_stored_canonical\tn_found_canonical\n";
+  for (const std::string& s: hard_newicks)
+  {
+    std::cout << s;
+    for (const bool canonical: { false, true })
+    {
+      const auto f = [canonical](const std::vector<int>& v)
+      {
+        return canonical ? GetCanonicalNewick(v) : v;
+      };
+      std::set<std::vector<int>> stored{f(StringToNewick(s))};
+      std::vector<std::vector<int>> level{*stored.begin()};
+      int n_found = 0;
+      for (int i=0; i!=n_levels; ++i)
+      {
+        std::vector<std::vector<int>> next_level;
+        for (const auto& v: level)
+        {
+          for (const auto& p: GetSimplerNewicksFrequencyPairs(v))
+          {
+            const std::vector<int> w = f(p.first);
+            if (stored.insert(w).second) { next_level.push_back(w); }
+            else { ++n_found; }
+          }
+        }
+        level.swap(next_level);
+      }
+      std::cout << '\t' << stored.size() << '\t' << n_found;
+    }
+    std::cout << '\n';
+  }
+}
+
+///Compare the time to find all Newicks that can be derived from a Newick
+///in a NewickStorage and in a NewickHashStorage
+void BenchmarkNewickHashStorage()
+{
+  using namespace ribi::newick;
+  std::cout << "Time to find each stored Newick in NewickStorage versus NewickHashStorage\n"
+    << "newick\tn_newicks\tNewickStorage (s)\tNewickHashStorage (s)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((1,2),(3,(4,5)),(6,7))" })
+  {
+    //All Newicks that can be derived from s
+    std::set<std::vector<int>> newicks;
+    std::vector<std::vector<int>> todo{StringToNewick(s)};
+    while (!todo.empty())
+    {
+      const std::vector<int> v = todo.back();
+      todo.pop_back();
+      if (!newicks.insert(v).second) continue;
+      for (const auto& w: GetSimplerNewicks(v)) todo.push_back(w);
+    }
+    const std::vector<SmallNewick> small_newicks(newicks.begin(), newicks.end());
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    ribi::NewickHashStorage<SmallNewick> hash_storage(n);
+    for (const auto& m: small_newicks)
+    {
+      storage.Store(m, 0.5);
+      hash_storage.Store(m, 0.5);
+    }
+    double sum = 0.0;
+    const int n_repeats = 100;
+    const double t_map = MeasureTime(
+      [&]() { for (const auto& m: small_newicks) sum += storage.Find(m); }, n_repeats
+    );
+    const double t_hash = MeasureTime(
+      [&]() { for (const auto& m: small_newicks) sum += hash_storage.Find(m); }, n_repeats
+    );
+    std::cout << s << '\t' << newicks.size() << '\t'
+      << (t_map / n_repeats) << '\t' << (t_hash / n_repeats) << '\n';
+    if (sum == 0.0) std::cout << "Should not get here\n";
+  }
+}
+
+///Compare the memory that GetSimplerNewicksFrequencyPairs writes to create
+///the simpler Newicks of hard biological Newicks, on std::vector<int>
+///versus on PersistentNewick, which shares the unchanged subtrees
+void BenchmarkPersistentNewick()
+{
+  using namespace ribi::newick;
+  std::cout << "Memory written by GetSimplerNewicksFrequencyPairs "
+    << "on std::vector<int> versus PersistentNewick\n"
+    << "size\tn_newicks\tvector (elements)\tvector (allocations)\tvector (s)"
+    << "\tPersistentNewick (nodes)\tPersistentNewick (allocations)\tPersistentNewick (s)\n";
+  for (const std::string& s: GetHardBiologicalNewicks())
+  {
+    const std::vector<int> v{StringToNewick(s)};
+    const PersistentNewick n(v);
+    n_allocations = 0;
+    const auto simpler_vectors = GetSimplerNewicksFrequencyPairs(v);
+    const std::size_t n_allocations_vector = n_allocations;
+    n_allocations = 0;
+    const auto simpler = GetSimplerNewicksFrequencyPairs(n);
+    const std::size_t n_allocations_persistent = n_allocations;
+
+    std::size_t n_elements = 0;
+    for (const auto& p: simpler_vectors) n_elements += p.first.size();
+    std::vector<PersistentNewick> newicks{n};
+    for (const auto& p: simpler) newicks.push_back(p.first);
+    const std::size_t n_nodes = CountNodes(newicks) - CountNodes( { n } );
+
+    const int n_repeats = 1000;
+    std::size_t sum = 0;
+    const double t_vector = MeasureTime(
+      [&]() { sum += GetSimplerNewicksFrequencyPairs(v).size(); }, n_repeats
+    );
+    const double t_persistent = MeasureTime(
+      [&]() { sum += GetSimplerNewicksFrequencyPairs(n).size(); }, n_repeats
+    );
+    std::cout << v.size() << '\t' << simpler.size() << '\t'
+      << n_elements << '\t' << n_allocations_vector << '\t' << (t_vector / n_repeats) << '\t'
+      << n_nodes << '\t' << n_allocations_persistent << '\t' << (t_persistent / n_repeats) << '\n';
+    if (sum == 0) std::cout << "Should not get here\n";
+  }
+}
+
+///Compare the heap allocations of creating the simpler Newicks of all Newicks
+///derived from a Newick, returned in new std::vectors versus written to
+///reused buffers, and count those of CalculateProbability
+void BenchmarkVisitSimplerNewicks()
+{
+  using namespace ribi::newick;
+  std::cout << "Heap allocations of creating simpler Newicks in new versus reused buffers\n"
+    << "newick\tn_newicks\tvector (allocations)\tVisitSimplerNewicksFrequencyPairs (allocations)"
+    << "\tSmallNewick (allocations)\tSmallNewick reused (allocations)"
+    << "\tCalculateProbability (allocations)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((1,2),(3,(4,5)),(6,7))" })
+  {
+    //All Newicks that can be derived from s
+    std::set<std::vector<int>> newicks;
+    std::vector<std::vector<int>> todo{StringToNewick(s)};
+    while (!todo.empty())
+    {
+      const std::vector<int> v = todo.back();
+      todo.pop_back();
+      if (!newicks.insert(v).second) continue;
+      for (const auto& w: GetSimplerNewicks(v)) todo.push_back(w);
+    }
+    const std::vector<SmallNewick> small_newicks(newicks.begin(), newicks.end());
+    std::vector<int> buffer;
+    buffer.reserve(StringToNewick(s).size());
+    std::vector<std::pair<SmallNewick, int>> small_buffer;
+    int sum = 0;
+
+    n_allocations = 0;
+    for (const auto& v: newicks) sum += GetSimplerNewicksFrequencyPairs(v).size();
+    const std::size_t n_allocations_vector = n_allocations;
+
+    n_allocations = 0;
+    for (const auto& v: newicks)
+    {
+      VisitSimplerNewicksFrequencyPairs(v, buffer,
+        [&sum](const std::vector<int>&, const int frequency) { sum += frequency; }
+      );
+    }
+    const std::size_t n_allocations_visit = n_allocations;
+
+    n_allocations = 0;
+    for (const auto& n: small_newicks) sum += GetSimplerNewicksFrequencyPairs(n).size();
+    const std::size_t n_allocations_small = n_allocations;
+
+    n_allocations = 0;
+    for (const auto& n: small_newicks)
+    {
+      GetSimplerNewicksFrequencyPairs(n, small_buffer);
+      sum += small_buffer.size();
+    }
+    const std::size_t n_allocations_small_reused = n_allocations;
+
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickHashStorage<SmallNewick> storage(n);
+    n_allocations = 0;
+    const double p = CalculateProbability(n, 10.0, storage);
+    const std::size_t n_allocations_probability = n_allocations;
+
+    std::cout << s << '\t' << newicks.size() << '\t'
+      << n_allocations_vector << '\t' << n_allocations_visit << '\t'
+      << n_allocations_small << '\t' << n_allocations_small_reused << '\t'
+      << n_allocations_probability << '\n';
+    if (sum == 0 || p == 0.0) std::cout << "Should not get here\n";
+  }
+}
+
+///Compare the time to create the simpler Newicks of all Newicks derived from
+///a binary Newick, and to calculate its probability, with the kernel of
+///the general versus the binary arity policy
+void BenchmarkArityPolicy()
+{
+  using namespace ribi::newick;
+  std::cout << "Time of the general versus the binary kernel on binary Newicks\n"
+    << "newick\tn_newicks\tvector general (s)\tvector binary (s)"
+    << "\tSmallNewick general (s)\tSmallNewick binary (s)"
+    << "\tCalculateProbability general (s)\tCalculateProbability binary (s)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "(((3,4),(5,6)),((3,2),4))" })
+  {
+    //All Newicks that can be derived from s
+    std::set<std::vector<int>> newicks;
+    std::vector<std::vector<int>> todo{StringToNewick(s)};
+    while (!todo.empty())
+    {
+      const std::vector<int> v = todo.back();
+      todo.pop_back();
+      if (!newicks.insert(v).second) continue;
+      for (const auto& w: GetSimplerNewicks(v)) todo.push_back(w);
+    }
+    //Only Newicks that are not simple are expanded by CalculateProbability
+    std::vector<std::vector<int>> complex_newicks;
+    for (const auto& v: newicks) if (!IsSimple(v)) complex_newicks.push_back(v);
+    const std::vector<SmallNewick> small_newicks(complex_newicks.begin(), complex_newicks.end());
+    std::vector<std::pair<std::vector<int>,int>> buffer;
+    std::vector<std::pair<SmallNewick,int>> small_buffer;
+    std::size_t sum = 0;
+    const int n_repeats = 10;
+
+    const double t_vector_general = MeasureTime([&]()
+      {
+        for (const auto& v: complex_newicks) { GetSimplerNewicksFrequencyPairs(v, buffer); sum += buffer.size(); }
+      }, n_repeats
+    );
+    const double t_vector_binary = MeasureTime([&]()
+      {
+        for (const auto& v: complex_newicks) { GetSimplerBinaryNewicksFrequencyPairs(v, buffer); sum += buffer.size(); }
+      }, n_repeats
+    );
+    const double t_small_general = MeasureTime([&]()
+      {
+        for (const auto& n: small_newicks) { GetSimplerNewicksFrequencyPairs(n, small_buffer); sum += small_buffer.size(); }
+      }, n_repeats
+    );
+    const double t_small_binary = MeasureTime([&]()
+      {
+        for (const auto& n: small_newicks) { GetSimplerBinaryNewicksFrequencyPairs(n, small_buffer); sum += small_buffer.size(); }
+      }, n_repeats
+    );
+    const SmallNewick n(StringToNewick(s));
+    double p = 0.0;
+    const double t_probability_general = MeasureTime([&]()
+      {
+        ribi::NewickHashStorage<SmallNewick> storage(n);
+        p += CalculateProbabilityByArity<GeneralArityPolicy>(n, 10.0, storage);
+      }, n_repeats
+    );
+    const double t_probability_binary = MeasureTime([&]()
+      {
+        ribi::NewickHashStorage<SmallNewick> storage(n);
+        p += CalculateProbabilityByArity<BinaryArityPolicy>(n, 10.0, storage);
+      }, n_repeats
+    );
+    std::cout << s << '\t' << newicks.size() << '\t'
+      << (t_vector_general / n_repeats) << '\t' << (t_vector_binary / n_repeats) << '\t'
+      << (t_small_general / n_repeats) << '\t' << (t_small_binary / n_repeats) << '\t'
+      << (t_probability_general / n_repeats) << '\t' << (t_probability_binary / n_repeats) << '\n';
+    if (sum == 0 || p == 0.0) std::cout << "Should not get here\n";
+  }
+}
+
+///Compare the time to calculate the probability of a Newick, and the number
+///of Newicks kept in memory, of CalculateProbability and CalculateProbabilityByLevels
+void BenchmarkLevels()
+{
+  using namespace ribi::newick;
+  std::cout << "Time and Newicks kept in memory by CalculateProbability versus CalculateProbabilityByLevels\n"
+    << "newick\tn_newicks stored\tmax n_newicks by levels\tCalculateProbability (s)\tCalculateProbabilityByLevels (s)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((200,20),20)", "((1000,20),20)" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    int n_newicks = 0;
+    int max_n_newicks = 0;
+    double p = 0.0;
+    double p_by_levels = 0.0;
+    const double t_probability = MeasureTime([&]()
+      {
+        ribi::NewickHashStorage<SmallNewick> storage(n);
+        p = CalculateProbability(n, 10.0, storage);
+        n_newicks = storage.CountNewicks();
+      }, 1
+    );
+    const double t_by_levels = MeasureTime([&]()
+      {
+        p_by_levels = CalculateProbabilityByLevels<SmallNewick, std::unordered_map<SmallNewick,double,NewickHash>>(
+          n, 10.0, max_n_newicks
+        );
+      }, 1
+    );
+    std::cout << s << '\t' << n_newicks << '\t' << max_n_newicks << '\t'
+      << t_probability << '\t' << t_by_levels << '\n';
+    if (std::abs(p - p_by_levels) > 1.0e-6 * p) std::cout << "Should not get here\n";
+  }
+}
+
+///Compare the time to calculate the probabilities of a Newick for many thetas
+///with CalculateProbability per theta and with CalculateProbabilities
+void BenchmarkCalculateProbabilities()
+{
+  using namespace ribi::newick;
+  std::cout << "Time of CalculateProbability per theta versus CalculateProbabilities on all thetas\n"
+    << "newick\tn_thetas\tCalculateProbability (s)\tCalculateProbabilities (s)\n";
+  std::vector<double> thetas;
+  for (int i=1; i!=33; ++i) thetas.push_back(0.5 * static_cast<double>(i));
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((200,20),20)" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    std::vector<double> ps(thetas.size(), 0.0);
+    std::vector<double> ps_all;
+    const double t_probability = MeasureTime([&]()
+      {
+        for (std::size_t i=0; i!=thetas.size(); ++i)
+        {
+          ribi::NewickHashStorage<SmallNewick> storage(n);
+          ps[i] = CalculateProbability(n, thetas[i], storage);
+        }
+      }, 1
+    );
+    const double t_probabilities = MeasureTime([&]()
+      {
+        ps_all = CalculateProbabilities<SmallNewick, std::unordered_map<SmallNewick,int,NewickHash>>(n, thetas);
+      }, 1
+    );
+    std::cout << s << '\t' << thetas.size() << '\t' << t_probability << '\t' << t_probabilities << '\n';
+    for (std::size_t i=0; i!=thetas.size(); ++i)
+    {
+      if (std::abs(ps[i] - ps_all[i]) > 1.0e-6 * ps[i]) std::cout << "Should not get here\n";
+    }
+  }
+}
+
+///Compare the time to calculate the probability of a Newick with
+///CalculateProbability, with the time to build its NewickProbabilityPlan
+///once and the time of each sweep over it
+void BenchmarkNewickProbabilityPlan()
+{
+  using namespace ribi::newick;
+  std::cout << "Time of building a NewickProbabilityPlan and of a sweep per theta versus CalculateProbability\n"
+    << "newick\tn_states\tn_edges\tCalculateProbability (s)\tbuild plan (s)\tsweep (s)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((200,20),20)" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    double p = 0.0;
+    const double t_probability = MeasureTime([&]()
+      {
+        ribi::NewickHashStorage<SmallNewick> storage(n);
+        p = CalculateProbability(n, 10.0, storage);
+      }, 1
+    );
+    std::vector<NewickProbabilityPlan> plans;
+    const double t_build = MeasureTime([&]()
+      {
+        plans.push_back(NewickProbabilityPlan(StringToNewick(s)));
+      }, 1
+    );
+    const int n_repeats = 10;
+    double p_plan = 0.0;
+    const double t_sweep = MeasureTime([&]()
+      {
+        p_plan = plans.back().CalculateProbability(10.0);
+      }, n_repeats
+    );
+    std::cout << s << '\t' << plans.back().CountStates() << '\t' << plans.back().CountEdges() << '\t'
+      << t_probability << '\t' << t_build << '\t' << (t_sweep / n_repeats) << '\n';
+    if (std::abs(p - p_plan) > 1.0e-6 * p) std::cout << "Should not get here\n";
+  }
+}
+
+///Compare the time to calculate the probability of a Newick with a sweep
+///over its NewickProbabilityPlan, with the time to calculate its probability
+///as a NewickRationalFunction once and the time of each evaluation of it
+void BenchmarkNewickRationalFunction()
+{
+  using namespace ribi::newick;
+  std::cout << "Time of calculating a NewickRationalFunction once and of evaluating it versus a sweep\n"
+    << "newick\tdegree\tsweep (s)\tcalculate function (s)\tevaluate (s)\trelative difference\n";
+  for (const std::string s: { "((5,5),5)", "((10,10),10)", "((5,5),(5,5))", "((20,20),20)" })
+  {
+    const NewickProbabilityPlan plan(StringToNewick(s));
+    const int n_repeats = 10;
+    double p = 0.0;
+    const double t_sweep = MeasureTime([&]() { p = plan.CalculateProbability(10.0); }, n_repeats);
+    std::vector<NewickRationalFunction> functions;
+    const double t_function = MeasureTime([&]()
+      {
+        functions.push_back(plan.CalculateProbabilityFunction());
+      }, 1
+    );
+    double p_function = 0.0;
+    const double t_evaluate = MeasureTime([&]() { p_function = functions.back().Evaluate(10.0); }, n_repeats);
+    std::cout << s << '\t' << functions.back().GetDenominator().size() - 1 << '\t'
+      << (t_sweep / n_repeats) << '\t' << t_function << '\t' << (t_evaluate / n_repeats) << '\t'
+      << (std::abs(p - p_function) / p) << '\n';
+  }
+}
+
+///Compare the time to calculate the first and second derivative of the
+///probability with respect to theta, by central finite differences
+///(three calculations) and by one calculation with DualNumbers
+void BenchmarkDualNumber()
+{
+  using namespace ribi::newick;
+  std::cout << "Time of finite differences versus DualNumber for the derivatives of the probability\n"
+    << "newick\tfinite differences (s)\tDualNumber (s)\n";
+  for (const std::string s: { "((20,20),20)", "((10,10),(10,10))", "((200,20),20)" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    const double theta = 10.0;
+    const double h = 0.001;
+    std::vector<double> ps;
+    const double t_finite_differences = MeasureTime([&]()
+      {
+        for (const double t: { theta - h, theta, theta + h })
+        {
+          ribi::NewickHashStorage<SmallNewick> storage(n);
+          ps.push_back(CalculateProbability(n, t, storage));
+        }
+      }, 1
+    );
+    DualNumber p;
+    const double t_dual_number = MeasureTime([&]()
+      {
+        ribi::NewickStorage<SmallNewick, std::unordered_map<SmallNewick,DualNumber,NewickHash>> storage(n);
+        p = CalculateProbability(n, DualNumber::CreateVariable(theta), storage);
+      }, 1
+    );
+    std::cout << s << '\t' << t_finite_differences << '\t' << t_dual_number << '\n';
+    if (std::abs(p.GetValue() - ps[1]) > 1.0e-6 * ps[1]) std::cout << "Should not get here\n";
+  }
+}
+
+} //~namespace
+
+int main()
+{
+  std::srand(42);
+  BenchmarkCheckNewick();
+  BenchmarkCheckNewickVector();
+  BenchmarkParseNewick();
+  BenchmarkValidateNewick();
+  BenchmarkNewickCorpus();
+  BenchmarkGetDepthParallel();
+  BenchmarkCompactNewick();
+  BenchmarkSmallNewick();
+  BenchmarkCanonicalNewick();
+  BenchmarkNewickHashStorage();
+  BenchmarkPersistentNewick();
+  BenchmarkVisitSimplerNewicks();
+  BenchmarkArityPolicy();
+  BenchmarkLevels();
+  BenchmarkCalculateProbabilities();
+  BenchmarkNewickProbabilityPlan();
+  BenchmarkNewickRationalFunction();
+  BenchmarkDualNumber();
+}
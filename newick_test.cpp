@@ -8,6 +8,7 @@
 #include <functional>
 #include <map>
 #include <numeric>
+#include <random>
 #include <set>
 #include <stdexcept>
 #include <string>
@@ -168,6 +169,11 @@ BOOST_AUTO_TEST_CASE(ribi_newick_GetLeafMaxArity)
   BOOST_CHECK(ribi::newick::GetLeafMaxArity(ribi::newick::StringToNewick("((1,2,3),4)"))   == 3);
   BOOST_CHECK(ribi::newick::GetLeafMaxArity(ribi::newick::StringToNewick("((12,2,3),4)"))  == 3);
   BOOST_CHECK(ribi::newick::GetLeafMaxArity(ribi::newick::StringToNewick("((123,2,3),4)")) == 3);
+  //The maximum of all leaves, not the arity of the last
+  BOOST_CHECK(ribi::newick::GetLeafMaxArity(ribi::newick::StringToNewick("((1,2,3),(4,5))")) == 3);
+  BOOST_CHECK(ribi::newick::GetLeafMaxArity(ribi::newick::StringToNewick("((4,5),(1,2,3))")) == 3);
+  BOOST_CHECK(!ribi::newick::IsBinaryNewick(ribi::newick::StringToNewick("((1,2,3),(4,5))")));
+  BOOST_CHECK(!ribi::newick::IsBinaryNewick(ribi::newick::StringToNewick("((1,2),(3,(4,5,6)),7)")));
 }
 
 BOOST_AUTO_TEST_CASE(ribi_newick_CalcDenominator)
@@ -204,6 +210,26 @@ BOOST_AUTO_TEST_CASE(ribi_newick_FindPosAfter_and_FindPosBefore)
   BOOST_CHECK(ribi::newick::FindPosBefore(v,0,4)==0);
 }
 
+BOOST_AUTO_TEST_CASE(ribi_newick_GetCanonicalNewick)
+{
+  using namespace ribi::newick;
+  const std::vector<int> v = StringToNewick("((1,2),3)");
+  BOOST_CHECK(GetCanonicalNewick(v) == v);
+  BOOST_CHECK(GetCanonicalNewick(StringToNewick("(3,(2,1))")) == v);
+  BOOST_CHECK(GetCanonicalNewick(StringToNewick("(3,(1,2))")) == v);
+  BOOST_CHECK(
+    GetCanonicalNewick(StringToNewick("(4,((3,2),1),(5,(6,1)))"))
+    == StringToNewick("(((1,6),5),((2,3),1),4)")
+  );
+  for (const std::string& s: CreateValidNewicks())
+  {
+    const std::vector<int> w = GetCanonicalNewick(StringToNewick(s));
+    BOOST_CHECK(IsNewick(w));
+    BOOST_CHECK(GetCanonicalNewick(w) == w);
+    BOOST_CHECK_EQUAL(w.size(), StringToNewick(s).size());
+  }
+}
+
 BOOST_AUTO_TEST_CASE(ribi_newick_GetDepth)
 {
   {
@@ -526,3 +552,291 @@ BOOST_AUTO_TEST_CASE(ribi_newick_compare_GetSimplerNewicks_and_GetSimplerNewicks
       == NewickCpp98().GetSimplerNewicksFrequencyPairs(newick));
   }
 }
+
+BOOST_AUTO_TEST_CASE(ribi_newick_VisitSimplerNewicksFrequencyPairs)
+{
+  using namespace ribi::newick;
+  std::vector<std::string> newicks{CreateValidNewicks()};
+  for (int i=2; i!=30; ++i)
+  {
+    newicks.push_back(CreateRandomNewick(i, 3));
+  }
+  std::vector<int> buffer;
+  std::vector<std::pair<std::vector<int>,int>> reused;
+  for (const std::string& s: newicks)
+  {
+    const std::vector<int> v{StringToNewick(s)};
+    const auto expected = NewickCpp98().GetSimplerNewicksFrequencyPairs(v);
+    //The buffer is only reallocated if v does not fit
+    buffer.reserve(v.size());
+    const int * const data = buffer.data();
+    std::vector<std::pair<std::vector<int>,int>> visited;
+    VisitSimplerNewicksFrequencyPairs(v, buffer,
+      [&visited](const std::vector<int>& w, const int frequency)
+      {
+        visited.push_back(std::make_pair(w, frequency));
+      }
+    );
+    BOOST_CHECK(visited == expected);
+    BOOST_CHECK(buffer.data() == data);
+    GetSimplerNewicksFrequencyPairs(v, reused);
+    BOOST_CHECK(reused == expected);
+    //The caller-owned buffer is reused as well
+    GetSimplerNewicksFrequencyPairs(v, reused, buffer);
+    BOOST_CHECK(reused == expected);
+    BOOST_CHECK(buffer.data() == data);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_GetSimplerBinaryNewicksFrequencyPairs_reused)
+{
+  using namespace ribi::newick;
+  std::vector<std::vector<int>> newicks;
+  for (const std::string& s: CreateValidBinaryNewicks())
+  {
+    newicks.push_back(StringToNewick(s));
+  }
+  for (int i=2; i!=30; ++i)
+  {
+    newicks.push_back(CreateRandomBinaryNewickVector(i, 4));
+  }
+  std::vector<std::pair<std::vector<int>,int>> reused;
+  for (const std::vector<int>& v: newicks)
+  {
+    BOOST_REQUIRE(IsBinaryNewick(v));
+    GetSimplerBinaryNewicksFrequencyPairs(v, reused);
+    BOOST_CHECK(reused == GetSimplerNewicksFrequencyPairs(v));
+    BOOST_CHECK(reused == GetSimplerBinaryNewicksFrequencyPairs(v));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CheckNewick_and_CheckNewickByCuttingLeaves_must_agree)
+{
+  //Returns the error message, or an empty string if s is a valid Newick
+  const auto check = [](const std::function<void(const std::string&)>& f, const std::string& s)
+  {
+    try { f(s); }
+    catch (const std::exception& e) { return std::string(e.what()); }
+    return std::string();
+  };
+  const std::function<void(const std::string&)> fast
+    = [](const std::string& s) { ribi::newick::CheckNewick(s); };
+  const std::function<void(const std::string&)> slow
+    = [](const std::string& s) { ribi::newick::CheckNewickByCuttingLeaves(s); };
+
+  std::vector<std::string> v = ribi::newick::CreateValidNewicks();
+  {
+    const std::vector<std::string> w = ribi::newick::CreateInvalidNewicks();
+    std::copy(std::begin(w), std::end(w), std::back_inserter(v));
+  }
+  //Create random strings from Newick characters
+  std::mt19937 rng(42);
+  const std::string chars = "((((())))),,,1123x";
+  for (int i=0; i!=10000; ++i)
+  {
+    std::string s = "(";
+    const int sz = std::uniform_int_distribution<int>(1,12)(rng);
+    for (int j=0; j!=sz; ++j)
+    {
+      s += chars[std::uniform_int_distribution<int>(0,chars.size() - 1)(rng)];
+    }
+    s += ")";
+    v.push_back(s);
+  }
+  for (const std::string& s: v)
+  {
+    const std::string msg = check(fast, s);
+    //CheckNewickByCuttingLeaves cannot handle values or brackets
+    //outside of the outer brackets
+    if (msg.find("outside of its outer brackets") != std::string::npos) continue;
+    BOOST_CHECK_EQUAL(msg, check(slow, s));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CheckNewick_and_CheckNewickByCuttingLeaves_must_agree_on_vectors)
+{
+  //Returns the error message, or an empty string if v is a valid Newick
+  const auto check = [](const std::function<void(const std::vector<int>&)>& f, const std::vector<int>& v)
+  {
+    try { f(v); }
+    catch (const std::exception& e) { return std::string(e.what()); }
+    return std::string();
+  };
+  const std::function<void(const std::vector<int>&)> fast
+    = [](const std::vector<int>& v) { ribi::newick::CheckNewick(v); };
+  const std::function<void(const std::vector<int>&)> slow
+    = [](const std::vector<int>& v) { ribi::newick::CheckNewickByCuttingLeaves(v); };
+
+  std::vector<std::vector<int>> v;
+  for (const std::string& s: ribi::newick::CreateValidNewicks())
+  {
+    v.push_back(ribi::newick::StringToNewick(s));
+  }
+  //Create random vectors from Newick values
+  using ribi::newick::bracket_open;
+  using ribi::newick::bracket_close;
+  std::mt19937 rng(42);
+  const std::vector<int> values = {
+    bracket_open, bracket_open, bracket_open, bracket_open,
+    bracket_close, bracket_close, bracket_close, bracket_close,
+    0, 1, 1, 2, 3, ribi::newick::comma
+  };
+  for (int i=0; i!=10000; ++i)
+  {
+    std::vector<int> w = { bracket_open };
+    const int sz = std::uniform_int_distribution<int>(1,12)(rng);
+    for (int j=0; j!=sz; ++j)
+    {
+      w.push_back(values[std::uniform_int_distribution<int>(0,values.size() - 1)(rng)]);
+    }
+    w.push_back(bracket_close);
+    v.push_back(w);
+  }
+  for (const std::vector<int>& w: v)
+  {
+    const std::string msg = check(fast, w);
+    //CheckNewickByCuttingLeaves cannot handle values or brackets
+    //outside of the outer brackets
+    if (msg.find("outside of its outer brackets") != std::string::npos) continue;
+    BOOST_CHECK_EQUAL(msg, check(slow, w));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ParseNewick_on_valid_newicks)
+{
+  using namespace ribi::newick;
+  std::vector<int> v;
+  for (const std::string& s: CreateValidNewicks())
+  {
+    const NewickError error = ParseNewick(s, v);
+    BOOST_CHECK(error.code == NewickErrorCode::none);
+    BOOST_CHECK(v == StringToNewick(s));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ParseNewick_on_invalid_newicks)
+{
+  using namespace ribi::newick;
+  std::vector<int> v;
+  for (const std::string& s: CreateInvalidNewicks())
+  {
+    const NewickError error = ParseNewick(s, v);
+    BOOST_CHECK(error.code != NewickErrorCode::none);
+    std::string what;
+    try { CheckNewick(s); } catch (const std::invalid_argument& e) { what = e.what(); }
+    BOOST_CHECK_EQUAL(GetNewickErrorMessage(error, s), what);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ParseNewick_error_positions)
+{
+  using namespace ribi::newick;
+  std::vector<int> v;
+  const std::vector<std::tuple<std::string,NewickErrorCode,std::size_t>> expected = {
+    std::make_tuple("(1"         , NewickErrorCode::too_short                 , 0),
+    std::make_tuple("1,2)"       , NewickErrorCode::no_opening_bracket        , 0),
+    std::make_tuple("(1,2"       , NewickErrorCode::no_closing_bracket        , 3),
+    std::make_tuple("(1,2))"     , NewickErrorCode::unmatched_brackets        , 5),
+    std::make_tuple("((1,2)"     , NewickErrorCode::unmatched_brackets        , 0),
+    std::make_tuple("(1,(0,2))"  , NewickErrorCode::zero_after_bracket        , 4),
+    std::make_tuple("(1,0)"      , NewickErrorCode::zero_after_comma          , 3),
+    std::make_tuple("(1,())"     , NewickErrorCode::empty_brackets            , 4),
+    std::make_tuple("(1,,2)"     , NewickErrorCode::consecutive_commas        , 3),
+    std::make_tuple("(,2)"       , NewickErrorCode::comma_after_bracket_open  , 1),
+    std::make_tuple("(1,)"       , NewickErrorCode::comma_before_bracket_close, 3),
+    std::make_tuple("(1,(2,x))"  , NewickErrorCode::invalid_character         , 6),
+    std::make_tuple("((2))"      , NewickErrorCode::double_brackets           , 1),
+    std::make_tuple("(1,(2))"    , NewickErrorCode::complex_leaf              , 3),
+    std::make_tuple("(1,2),(3,4)", NewickErrorCode::outside_outer_brackets    , 6),
+    std::make_tuple("(1,99999999999)", NewickErrorCode::value_too_large       , 3)
+  };
+  for (const auto& t: expected)
+  {
+    const NewickError error = ParseNewick(std::get<0>(t), v);
+    BOOST_CHECK(error.code == std::get<1>(t));
+    BOOST_CHECK_EQUAL(error.position, std::get<2>(t));
+  }
+  //The validators reject values that do not fit in an int as ParseNewick does
+  for (const std::string s: { "(1,99999999999)", "(99999999999)", "((1,2147483648),3)" })
+  {
+    const NewickError error = ParseNewick(s, v);
+    BOOST_CHECK(error.code == NewickErrorCode::value_too_large);
+    BOOST_CHECK(ValidateNewick(s).code == error.code);
+    BOOST_CHECK_EQUAL(ValidateNewick(s).position, error.position);
+    BOOST_CHECK(!IsNewick(s));
+    BOOST_CHECK_THROW(CheckNewick(s), std::invalid_argument);
+  }
+  BOOST_CHECK(IsNewick("((1,2147483647),3)"));
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ValidateNewick_on_strings)
+{
+  using namespace ribi::newick;
+  for (const std::string& s: CreateValidNewicks())
+  {
+    BOOST_CHECK(ValidateNewick(s).code == NewickErrorCode::none);
+  }
+  for (const std::string& s: CreateInvalidNewicks())
+  {
+    const NewickError error = ValidateNewick(s);
+    BOOST_CHECK(error.code != NewickErrorCode::none);
+    BOOST_CHECK_THROW(CheckNewick(s), std::invalid_argument);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ValidateNewick_on_vectors)
+{
+  using namespace ribi::newick;
+  const int o = bracket_open;
+  const int c = bracket_close;
+  const std::vector<std::tuple<std::vector<int>,NewickErrorCode,std::size_t>> expected = {
+    std::make_tuple(std::vector<int>{ o, 1, 2, c }           , NewickErrorCode::none                  , 0),
+    std::make_tuple(std::vector<int>{ o, 1 }                 , NewickErrorCode::too_short             , 0),
+    std::make_tuple(std::vector<int>{ 1, 2, c }              , NewickErrorCode::no_opening_bracket    , 0),
+    std::make_tuple(std::vector<int>{ o, 1, 2 }              , NewickErrorCode::no_closing_bracket    , 2),
+    std::make_tuple(std::vector<int>{ o, 1, 2, c, c }        , NewickErrorCode::unmatched_brackets    , 4),
+    std::make_tuple(std::vector<int>{ o, o, 1, 2, c }        , NewickErrorCode::unmatched_brackets    , 0),
+    std::make_tuple(std::vector<int>{ o, 1, 0, c }           , NewickErrorCode::zero_value            , 2),
+    std::make_tuple(std::vector<int>{ o, 1, o, c, c }        , NewickErrorCode::empty_brackets        , 3),
+    std::make_tuple(std::vector<int>{ o, 1, o, 2, comma, c, c }, NewickErrorCode::invalid_value       , 4),
+    std::make_tuple(std::vector<int>{ o, 1, c, 2, o, 3, c }  , NewickErrorCode::outside_outer_brackets, 4)
+  };
+  for (const auto& t: expected)
+  {
+    const std::vector<int>& v = std::get<0>(t);
+    const NewickError error = ValidateNewick(v);
+    BOOST_CHECK(error.code == std::get<1>(t));
+    BOOST_CHECK_EQUAL(error.position, std::get<2>(t));
+    BOOST_CHECK_EQUAL(IsNewick(v), error.code == NewickErrorCode::none);
+    //CheckNewickByCuttingLeaves cannot handle values or brackets
+    //outside of the outer brackets
+    if (error.code == NewickErrorCode::none
+      || error.code == NewickErrorCode::outside_outer_brackets) continue;
+    std::string what;
+    try { CheckNewickByCuttingLeaves(v); } catch (const std::exception& e) { what = e.what(); }
+    BOOST_CHECK_EQUAL(GetNewickErrorMessage(error, v), what);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_string_views_in_a_larger_buffer)
+{
+  using namespace ribi::newick;
+  const std::string buffer = "(1,(2,3));((4,5),6);(7,,8)";
+  const std::string_view all(buffer);
+  const std::string_view first = all.substr(0, 9);
+  const std::string_view second = all.substr(10, 9);
+  const std::string_view third = all.substr(20);
+  BOOST_CHECK(IsNewick(first));
+  BOOST_CHECK(IsNewick(second));
+  BOOST_CHECK(!IsNewick(third));
+  BOOST_CHECK(!IsNewick(all));
+  BOOST_CHECK(StringToNewick(first) == StringToNewick("(1,(2,3))"));
+  std::vector<int> v;
+  BOOST_CHECK(ParseNewick(second, v).code == NewickErrorCode::none);
+  BOOST_CHECK(v == StringToNewick("((4,5),6)"));
+  const NewickError error = ParseNewick(third, v);
+  BOOST_CHECK(error.code == NewickErrorCode::consecutive_commas);
+  BOOST_CHECK_EQUAL(error.position, 3);
+  BOOST_CHECK_THROW(CheckNewickForConsecutiveCommas(third), std::invalid_argument);
+  BOOST_CHECK_NO_THROW(CheckNewickForConsecutiveCommas(first));
+}
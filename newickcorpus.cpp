@@ -0,0 +1,130 @@
+#include "newickcorpus.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+///Parse all records in text
+std::vector<ribi::NewickRecord> ParseNewickRecords(const std::string_view text)
+{
+  std::vector<ribi::NewickRecord> records;
+  std::size_t i = 0;
+  std::string_view record;
+  while (ribi::FindNextNewickRecord(text, i, record))
+  {
+    ribi::NewickRecord r;
+    r.text = record;
+    r.error = ribi::newick::ParseNewick(record, r.newick);
+    records.push_back(std::move(r));
+  }
+  return records;
+}
+
+} //~namespace
+
+ribi::NewickCorpus::NewickCorpus(const std::string& filename)
+  : m_file{},
+    m_text{}
+{
+  std::ifstream f(filename, std::ios::binary | std::ios::ate);
+  if (!f.is_open())
+  {
+    throw std::invalid_argument("NewickCorpus: cannot open file '" + filename + "'");
+  }
+  //An empty file cannot be memory-mapped
+  if (f.tellg() == 0) return;
+  f.close();
+
+  m_file.open(filename);
+  if (!m_file.is_open())
+  {
+    throw std::invalid_argument("NewickCorpus: cannot memory-map file '" + filename + "'");
+  }
+  m_text = std::string_view(m_file.data(), m_file.size());
+}
+
+bool ribi::FindNextNewickRecord(
+  const std::string_view text,
+  std::size_t& i,
+  std::string_view& record
+) noexcept
+{
+  const std::size_t sz = text.size();
+  while (i != sz && IsNewickRecordSeparator(text[i])) ++i;
+  if (i == sz) return false;
+  const std::size_t begin = i;
+  while (i != sz && !IsNewickRecordSeparator(text[i])) ++i;
+  record = text.substr(begin, i - begin);
+  return true;
+}
+
+void ribi::NewickCorpus::ForEach(
+  const std::function<
+    void(
+      const std::string_view,
+      const std::vector<int>&,
+      const newick::NewickError&
+    )
+  >& f
+) const
+{
+  std::vector<int> newick;
+  std::size_t i = 0;
+  std::string_view record;
+  while (FindNextNewickRecord(m_text, i, record))
+  {
+    const newick::NewickError error = newick::ParseNewick(record, newick);
+    f(record, newick, error);
+  }
+}
+
+bool ribi::IsNewickRecordSeparator(const char c) noexcept
+{
+  return c == '\n' || c == ';' || c == '\r';
+}
+
+std::vector<ribi::NewickRecord> ribi::NewickCorpus::ParseAll(const int n_threads) const
+{
+  assert(n_threads >= 0);
+  const int n_chunks = n_threads != 0
+    ? n_threads
+    : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+  //Split the text into chunks, each ending at a record boundary
+  const std::size_t sz = m_text.size();
+  std::vector<std::size_t> bounds(1, 0);
+  for (int i=1; i!=n_chunks; ++i)
+  {
+    std::size_t bound = std::max(bounds.back(), sz * i / n_chunks);
+    while (bound != sz && !IsNewickRecordSeparator(m_text[bound])) ++bound;
+    bounds.push_back(bound);
+  }
+  bounds.push_back(sz);
+
+  //Parse each chunk in its own thread
+  std::vector<std::vector<NewickRecord>> chunks(n_chunks);
+  std::vector<std::thread> threads;
+  for (int i=0; i!=n_chunks; ++i)
+  {
+    const std::string_view chunk = m_text.substr(bounds[i], bounds[i + 1] - bounds[i]);
+    threads.push_back(
+      std::thread(
+        [chunk, &chunks, i]() { chunks[i] = ParseNewickRecords(chunk); }
+      )
+    );
+  }
+  for (std::thread& t: threads) t.join();
+
+  //Collect the records in order
+  std::vector<NewickRecord> records;
+  for (std::vector<NewickRecord>& chunk: chunks)
+  {
+    std::move(std::begin(chunk), std::end(chunk), std::back_inserter(records));
+  }
+  return records;
+}
@@ -0,0 +1,82 @@
+#ifndef NEWICKCORPUS_H
+#define NEWICKCORPUS_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "newick.h"
+
+namespace ribi {
+
+///NewickRecord is a single Newick from a NewickCorpus,
+///as parsed by newick::ParseNewick
+struct NewickRecord
+{
+  ///The text of the Newick, a view into its NewickCorpus
+  std::string_view text;
+
+  ///The Newick, with unspecified content if the text is invalid
+  std::vector<int> newick;
+
+  ///The error detected by newick::ParseNewick
+  newick::NewickError error;
+};
+
+///NewickCorpus reads a file with Newicks, separated by
+///newlines and/or semicolons, by memory-mapping it.
+///Empty records are skipped.
+///All record texts are views into the memory-mapped file,
+///which are valid as long as the NewickCorpus exists
+struct NewickCorpus
+{
+  ///Memory-maps the file. Throws std::invalid_argument if
+  ///the file cannot be opened
+  explicit NewickCorpus(const std::string& filename);
+
+  ///ForEach parses the records lazily in order, and calls f on each
+  ///with the record text, its Newick and its error. The Newick
+  ///is a buffer that is reused for all records
+  void ForEach(
+    const std::function<
+      void(
+        const std::string_view,
+        const std::vector<int>&,
+        const newick::NewickError&
+      )
+    >& f
+  ) const;
+
+  ///ParseAll parses all records. The file is split into chunks
+  ///at record boundaries, which are parsed by n_threads threads.
+  ///If n_threads is zero, one thread per core is used.
+  ///The records are returned in the order of the file
+  std::vector<NewickRecord> ParseAll(const int n_threads = 0) const;
+
+  ///The text of the whole file
+  std::string_view Peek() const noexcept { return m_text; }
+
+  private:
+  boost::iostreams::mapped_file_source m_file;
+  std::string_view m_text;
+};
+
+///FindNextNewickRecord finds the first record in text from index i on.
+///If found, returns true, sets record to it and sets i to the index
+///after it. Returns false if there are no records left
+bool FindNextNewickRecord(
+  const std::string_view text,
+  std::size_t& i,
+  std::string_view& record
+) noexcept;
+
+///IsNewickRecordSeparator returns true if c separates
+///two records in a NewickCorpus
+bool IsNewickRecordSeparator(const char c) noexcept;
+
+} //~namespace ribi
+
+#endif // NEWICKCORPUS_H
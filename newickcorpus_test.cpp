@@ -0,0 +1,114 @@
+#include "newickcorpus.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi;
+
+namespace {
+
+///Writes text to a file and returns its filename
+std::string CreateNewickCorpusFile(const std::string& text)
+{
+  const std::string filename{"newickcorpus_test.txt"};
+  std::ofstream f(filename, std::ios::binary);
+  f << text;
+  return filename;
+}
+
+} //~namespace
+
+BOOST_AUTO_TEST_CASE(ribi_newickcorpus_ForEach)
+{
+  const std::string filename{
+    CreateNewickCorpusFile("(1,2);\n(1,(2,3));\r\n\n(0,1);(1,(2,3),4)")
+  };
+  const NewickCorpus corpus(filename);
+  std::vector<std::string> texts;
+  std::vector<std::vector<int>> newicks;
+  std::vector<newick::NewickErrorCode> codes;
+  corpus.ForEach(
+    [&](
+      const std::string_view text,
+      const std::vector<int>& v,
+      const newick::NewickError& error
+    )
+    {
+      texts.push_back(std::string(text));
+      newicks.push_back(v);
+      codes.push_back(error.code);
+    }
+  );
+  const std::vector<std::string> expected_texts{
+    "(1,2)", "(1,(2,3))", "(0,1)", "(1,(2,3),4)"
+  };
+  BOOST_CHECK(texts == expected_texts);
+  BOOST_CHECK(codes[0] == newick::NewickErrorCode::none);
+  BOOST_CHECK(codes[1] == newick::NewickErrorCode::none);
+  BOOST_CHECK(codes[2] == newick::NewickErrorCode::zero_after_bracket);
+  BOOST_CHECK(codes[3] == newick::NewickErrorCode::none);
+  BOOST_CHECK(newicks[1] == newick::StringToNewick("(1,(2,3))"));
+  BOOST_CHECK(newicks[3] == newick::StringToNewick("(1,(2,3),4)"));
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newickcorpus_ParseAll_must_preserve_order)
+{
+  std::string text;
+  for (int i=1; i!=200; ++i)
+  {
+    text += "(" + std::to_string(i) + ",(" + std::to_string(i + 1) + ",3))";
+    text += i % 3 == 0 ? ";\n" : "\n";
+    if (i % 17 == 0) text += "(0,1)\n\n";
+  }
+  const std::string filename{CreateNewickCorpusFile(text)};
+  const NewickCorpus corpus(filename);
+
+  std::vector<NewickRecord> expected;
+  corpus.ForEach(
+    [&expected](
+      const std::string_view text,
+      const std::vector<int>& v,
+      const newick::NewickError& error
+    )
+    {
+      expected.push_back(NewickRecord{text, v, error});
+    }
+  );
+  BOOST_CHECK_EQUAL(expected.size(), 199 + 11);
+
+  for (const int n_threads: { 0, 1, 2, 3, 8, 1000 })
+  {
+    const std::vector<NewickRecord> records{corpus.ParseAll(n_threads)};
+    BOOST_REQUIRE_EQUAL(records.size(), expected.size());
+    for (std::size_t i=0; i!=records.size(); ++i)
+    {
+      BOOST_CHECK(records[i].text == expected[i].text);
+      BOOST_CHECK(records[i].error.code == expected[i].error.code);
+      if (records[i].error.code == newick::NewickErrorCode::none)
+      {
+        BOOST_CHECK(records[i].newick == expected[i].newick);
+      }
+    }
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newickcorpus_empty_and_missing_files)
+{
+  const std::string filename{CreateNewickCorpusFile("")};
+  const NewickCorpus corpus(filename);
+  BOOST_CHECK(corpus.Peek().empty());
+  BOOST_CHECK(corpus.ParseAll(4).empty());
+  std::remove(filename.c_str());
+
+  BOOST_CHECK_THROW(
+    NewickCorpus("newickcorpus_test_missing.txt"),
+    std::invalid_argument
+  );
+}
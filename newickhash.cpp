@@ -0,0 +1,37 @@
+#include "newickhash.h"
+
+#include <cassert>
+
+#include "newick.h"
+
+std::uint64_t ribi::newick::GetNewickElementHash(const int x) noexcept
+{
+  assert(x == bracket_open || x == bracket_close || x > 0);
+  //The SplitMix64 finalizer, so that each bit depends on each bit of x
+  std::uint64_t h = static_cast<std::uint64_t>(x - bracket_close + 1);
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111eb;
+  h ^= h >> 31;
+  return h;
+}
+
+std::uint64_t ribi::newick::GetNewickHash(
+  const int * const begin,
+  const int * const end
+) noexcept
+{
+  assert(IsNewick(std::vector<int>(begin, end)));
+  std::uint64_t hash = 0;
+  for (const int * i = begin; i != end; ++i)
+  {
+    hash = hash * newick_hash_base + GetNewickElementHash(*i);
+  }
+  return hash;
+}
+
+std::uint64_t ribi::newick::GetNewickHash(const std::vector<int>& v) noexcept
+{
+  return GetNewickHash(v.data(), v.data() + v.size());
+}
@@ -0,0 +1,58 @@
+#ifndef NEWICKHASH_H
+#define NEWICKHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "newickstorage.h"
+
+namespace ribi {
+namespace newick {
+
+///The base of the polynomial hash of GetNewickHash
+constexpr std::uint64_t newick_hash_base = 0x100000001b3;
+
+///GetNewickElementHash returns the value that an element,
+///a bracket or a frequency, adds to the hash of GetNewickHash
+std::uint64_t GetNewickElementHash(const int x) noexcept;
+
+///GetNewickHash returns a 64-bit polynomial hash of the valid Newick
+///in [begin,end), which is the sum of GetNewickElementHash(e[k]) *
+///newick_hash_base^(n-1-k) modulo 2^64. Equal Newicks have equal hashes.
+///The hash of the concatenation XY equals hash(X) * base^|Y| + hash(Y),
+///so the hash of a subtree follows from those of its children (as in a
+///Merkle tree), and changing, removing or inserting an element at a known
+///index changes the hash in constant time, given the hashes of the prefixes.
+///Takes linear time and does not allocate memory
+std::uint64_t GetNewickHash(const int * const begin, const int * const end) noexcept;
+
+///GetNewickHash returns the hash of a Newick std::vector<int>
+std::uint64_t GetNewickHash(const std::vector<int>& v) noexcept;
+
+///NewickHash is a hash function object for Newicks,
+///for any Newick type that has a GetNewickHash overload
+struct NewickHash
+{
+  template <class NewickType>
+  std::size_t operator()(const NewickType& n) const
+  {
+    return static_cast<std::size_t>(GetNewickHash(n));
+  }
+};
+
+} //~namespace newick
+
+///NewickHashStorage is a NewickStorage in which each lookup is a probe
+///of a hash table keyed on the GetNewickHash of the Newick,
+///followed by a full comparison of the Newicks to confirm the match
+template <class NewickType>
+using NewickHashStorage = NewickStorage<
+  NewickType,
+  std::unordered_map<NewickType, double, newick::NewickHash>
+>;
+
+} //~namespace ribi
+
+#endif // NEWICKHASH_H
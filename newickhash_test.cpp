@@ -0,0 +1,69 @@
+#include "newickhash.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "smallnewick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_GetNewickHash)
+{
+  const std::vector<int> v{StringToNewick("((1,2),3)")};
+  BOOST_CHECK_EQUAL(GetNewickHash(v), GetNewickHash(StringToNewick("((1,2),3)")));
+  BOOST_CHECK_EQUAL(GetNewickHash(v), GetNewickHash(SmallNewick(v)));
+  BOOST_CHECK(GetNewickHash(v) != GetNewickHash(StringToNewick("((2,1),3)")));
+  BOOST_CHECK(GetNewickHash(v) != GetNewickHash(StringToNewick("(3,(1,2))")));
+  BOOST_CHECK(GetNewickHash(v) != GetNewickHash(StringToNewick("(1,2,3)")));
+  BOOST_CHECK(GetNewickHash(v) != GetNewickHash(StringToNewick("(1,(2,3))")));
+  BOOST_CHECK(
+    GetNewickHash(StringToNewick("(2,(1,1))")) != GetNewickHash(StringToNewick("(2,1,1)"))
+  );
+
+  //Newicks deeper than the hashes of the subtrees kept without the heap
+  const auto create_deep = [](const int depth, const int f)
+  {
+    std::string s = std::to_string(f);
+    for (int i=0; i!=depth; ++i) s = "(1," + s + ")";
+    return s;
+  };
+  BOOST_CHECK(
+    GetNewickHash(StringToNewick("(" + create_deep(100, 2) + "," + create_deep(100, 3) + ")"))
+    != GetNewickHash(StringToNewick("(" + create_deep(100, 3) + "," + create_deep(100, 3) + ")"))
+  );
+
+  //No collisions among all Newicks that can be derived from a Newick
+  std::set<std::vector<int>> newicks;
+  std::vector<std::vector<int>> todo{StringToNewick("((3,2),(4,(1,2)),2)")};
+  while (!todo.empty())
+  {
+    const std::vector<int> w = todo.back();
+    todo.pop_back();
+    if (!newicks.insert(w).second) continue;
+    for (const auto& x: GetSimplerNewicks(w)) todo.push_back(x);
+  }
+  std::set<std::uint64_t> hashes;
+  for (const auto& w: newicks) hashes.insert(GetNewickHash(w));
+  BOOST_CHECK_EQUAL(hashes.size(), newicks.size());
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_NewickHashStorage)
+{
+  for (const std::string s: { "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    ribi::NewickHashStorage<SmallNewick> hash_storage(n);
+    BOOST_CHECK_EQUAL(
+      CalculateProbability(n, 10.0, hash_storage),
+      CalculateProbability(n, 10.0, storage)
+    );
+    BOOST_CHECK_EQUAL(hash_storage.CountNewicks(), storage.CountNewicks());
+    BOOST_CHECK_EQUAL(hash_storage.Find(n), storage.Find(n));
+    hash_storage.CleanUp();
+    BOOST_CHECK(hash_storage.CountNewicks() <= storage.CountNewicks());
+  }
+}
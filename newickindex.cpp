@@ -0,0 +1,70 @@
+#include "newickindex.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+#include "newick.h"
+#include "validatednewick.h"
+
+ribi::newick::NewickIndex::NewickIndex(const std::vector<int>& n)
+  : m_depths(n.size()),
+    m_matches(n.size(), npos),
+    m_next_siblings(n.size(), npos),
+    m_parents(n.size(), npos),
+    m_previous_siblings(n.size(), npos)
+{
+  //The opening brackets of the subtrees that are not yet closed,
+  //with the index of their last child so far
+  std::vector<std::pair<std::size_t, std::size_t>> open;
+  const std::size_t sz = n.size();
+  for (std::size_t i=0; i!=sz; ++i)
+  {
+    const int x = n[i];
+    if (x == bracket_close)
+    {
+      if (open.empty())
+      {
+        throw std::invalid_argument(
+          "A closing bracket of a Newick must match an opening bracket"
+        );
+      }
+      const std::size_t from = open.back().first;
+      open.pop_back();
+      m_matches[from] = i;
+      m_matches[i] = from;
+      m_parents[i] = m_parents[from];
+      m_depths[i] = static_cast<int>(open.size());
+      continue;
+    }
+    //x is a node
+    if (!open.empty())
+    {
+      m_parents[i] = open.back().first;
+      const std::size_t previous = open.back().second;
+      if (previous != npos)
+      {
+        m_previous_siblings[i] = previous;
+        m_next_siblings[previous] = i;
+      }
+      open.back().second = i;
+    }
+    if (x == bracket_open)
+    {
+      open.push_back(std::make_pair(i, npos));
+    }
+    m_depths[i] = static_cast<int>(open.size()) - 1;
+  }
+  if (!open.empty())
+  {
+    throw std::invalid_argument(
+      "An opening bracket of a Newick must match a closing bracket"
+    );
+  }
+}
+
+ribi::newick::NewickIndex::NewickIndex(const ValidatedNewick& n)
+  : NewickIndex(n.Peek())
+{
+
+}
@@ -0,0 +1,61 @@
+#ifndef NEWICKINDEX_H
+#define NEWICKINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+struct ValidatedNewick;
+
+///NewickIndex is the structure of a Newick std::vector<int>,
+///built in a single pass, so that functions that need the depth
+///of an element or the partner of a bracket do not rescan the Newick.
+///A node is either a frequency or an opening bracket of a subtree.
+///The first child of the subtree opened at index i is at index i + 1
+struct NewickIndex
+{
+  ///Indexes a Newick in linear time. Only the brackets of n are checked,
+  ///as the index is used by the functions that take a ValidatedNewick.
+  ///Throws std::invalid_argument if the brackets of n do not match
+  explicit NewickIndex(const std::vector<int>& n);
+  explicit NewickIndex(const ValidatedNewick& n);
+
+  ///Used for the absence of an element
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  ///The depth of each element, identical to GetDepth
+  const std::vector<int>& GetDepths() const noexcept { return m_depths; }
+
+  ///The index of the bracket that matches the bracket at index i,
+  ///npos if there is no bracket at index i
+  std::size_t GetMatchingBracket(const std::size_t i) const noexcept { return m_matches[i]; }
+
+  ///The index of the next sibling of the node at index i,
+  ///npos if there is none or if there is a closing bracket at index i
+  std::size_t GetNextSibling(const std::size_t i) const noexcept { return m_next_siblings[i]; }
+
+  ///The index of the opening bracket of the subtree that the element
+  ///at index i is in, npos for the outer brackets
+  std::size_t GetParent(const std::size_t i) const noexcept { return m_parents[i]; }
+
+  ///The index of the previous sibling of the node at index i,
+  ///npos if there is none or if there is a closing bracket at index i
+  std::size_t GetPreviousSibling(const std::size_t i) const noexcept { return m_previous_siblings[i]; }
+
+  ///The number of elements of the indexed Newick
+  std::size_t size() const noexcept { return m_depths.size(); }
+
+  private:
+  std::vector<int> m_depths;
+  std::vector<std::size_t> m_matches;
+  std::vector<std::size_t> m_next_siblings;
+  std::vector<std::size_t> m_parents;
+  std::vector<std::size_t> m_previous_siblings;
+};
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // NEWICKINDEX_H
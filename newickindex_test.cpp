@@ -0,0 +1,119 @@
+#include "newickindex.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickcpp98.h"
+#include "validatednewick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+namespace {
+
+///All valid Newicks used in testing, as std::vector<int>
+std::vector<std::vector<int>> CreateNewickIndexTestNewicks()
+{
+  std::vector<std::vector<int>> v;
+  for (const std::string& s: CreateValidNewicks())
+  {
+    v.push_back(StringToNewick(s));
+  }
+  for (int i=2; i!=50; ++i)
+  {
+    v.push_back(StringToNewick(CreateRandomNewick(i, 3)));
+  }
+  return v;
+}
+
+} //~namespace
+
+BOOST_AUTO_TEST_CASE(ribi_newick_NewickIndex)
+{
+  // ((12)(3(45)))
+  // 0123456789012
+  const std::vector<int> v{StringToNewick("((1,2),(3,(4,5)))")};
+  const NewickIndex index(v);
+  BOOST_CHECK_EQUAL(index.size(), v.size());
+  BOOST_CHECK(index.GetDepths() == GetDepth(v));
+  BOOST_CHECK_EQUAL(index.GetMatchingBracket(0), 12);
+  BOOST_CHECK_EQUAL(index.GetMatchingBracket(12), 0);
+  BOOST_CHECK_EQUAL(index.GetMatchingBracket(1), 4);
+  BOOST_CHECK_EQUAL(index.GetMatchingBracket(7), 10);
+  BOOST_CHECK_EQUAL(index.GetMatchingBracket(2), NewickIndex::npos);
+  BOOST_CHECK_EQUAL(index.GetParent(0), NewickIndex::npos);
+  BOOST_CHECK_EQUAL(index.GetParent(12), NewickIndex::npos);
+  BOOST_CHECK_EQUAL(index.GetParent(1), 0);
+  BOOST_CHECK_EQUAL(index.GetParent(4), 0);
+  BOOST_CHECK_EQUAL(index.GetParent(8), 7);
+  BOOST_CHECK_EQUAL(index.GetNextSibling(1), 5);
+  BOOST_CHECK_EQUAL(index.GetNextSibling(5), NewickIndex::npos);
+  BOOST_CHECK_EQUAL(index.GetNextSibling(6), 7);
+  BOOST_CHECK_EQUAL(index.GetNextSibling(4), NewickIndex::npos);
+  BOOST_CHECK_EQUAL(index.GetPreviousSibling(5), 1);
+  BOOST_CHECK_EQUAL(index.GetPreviousSibling(9), 8);
+  BOOST_CHECK_EQUAL(index.GetPreviousSibling(8), NewickIndex::npos);
+  BOOST_CHECK(NewickIndex(ValidatedNewick(v)).GetDepths() == index.GetDepths());
+  //Brackets that do not match
+  BOOST_CHECK_THROW(NewickIndex(std::vector<int>{bracket_close}), std::invalid_argument);
+  BOOST_CHECK_THROW(NewickIndex(std::vector<int>{bracket_open}), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    NewickIndex(std::vector<int>{bracket_open, 1, bracket_close, bracket_close}),
+    std::invalid_argument
+  );
+  BOOST_CHECK_THROW(
+    NewickIndex(std::vector<int>{bracket_open, bracket_open, 1, bracket_close}),
+    std::invalid_argument
+  );
+  BOOST_CHECK_NO_THROW(NewickIndex(std::vector<int>{}));
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_NewickIndex_overloads)
+{
+  for (const std::vector<int>& v: CreateNewickIndexTestNewicks())
+  {
+    const NewickIndex index(v);
+    BOOST_CHECK(index.GetDepths() == GetDepth(v));
+    BOOST_CHECK(
+      FindOpeningAndClosingBracketIndices(v, index)
+      == FindOpeningAndClosingBracketIndices(v)
+    );
+    BOOST_CHECK_EQUAL(GetLeafMaxArity(v, index), GetLeafMaxArity(v));
+    if (!IsUnaryNewick(v))
+    {
+      BOOST_CHECK(GetRootBranches(v, index) == GetRootBranches(v));
+    }
+    //The simpler Newicks of all frequencies of one are those of
+    //the original NewickCpp98 in which a one is merged with a sibling
+    std::vector<std::vector<int>> simpler;
+    const int sz = v.size();
+    for (int i=0; i!=sz; ++i)
+    {
+      if (v[i] != 1) continue;
+      for (const auto& w: GetSimplerNewicksHardFromHere(v, i, index)) simpler.push_back(w);
+    }
+    std::vector<std::vector<int>> expected;
+    for (const auto& q: ribi::NewickCpp98().GetSimplerNewicksFrequencyPairs(v))
+    {
+      if (q.second == 1) expected.push_back(q.first);
+    }
+    BOOST_CHECK(simpler == expected);
+  }
+  const std::vector<int> v{StringToNewick("(1,2,1)")};
+  const NewickIndex index(v);
+  BOOST_CHECK(
+    GetSimplerNewicksHardFromHere(v, 1, index)
+    == std::vector<std::vector<int>>( { StringToNewick("(3,1)"), StringToNewick("(2,2)") } )
+  );
+  BOOST_CHECK(
+    GetSimplerNewicksHardFromHere(v, 3, index)
+    == std::vector<std::vector<int>>( { StringToNewick("(1,3)"), StringToNewick("(2,2)") } )
+  );
+  const std::vector<int> w{StringToNewick("((1,2),(1,3))")};
+  BOOST_CHECK(
+    GetSimplerNewicksHardFromHere(w, 6, NewickIndex(w))
+    == std::vector<std::vector<int>>( { StringToNewick("((1,2),4)") } )
+  );
+}
@@ -0,0 +1,170 @@
+#include "newicklanes.h"
+
+#include <cassert>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define NEWICK_LANES_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void DivideLanesByDenominatorsScalar(
+  const double * const w,
+  const double d_0,
+  const double d_1,
+  const double * const thetas,
+  double * const ws,
+  const int from,
+  const int n
+) noexcept
+{
+  for (int i=from; i!=n; ++i) ws[i] = w[i] / (d_0 + (d_1 * thetas[i]));
+}
+
+void AddLaneProductsScalar(
+  double * const w,
+  const double * const ws,
+  const double * const thetas,
+  const int from,
+  const int n
+) noexcept
+{
+  for (int i=from; i!=n; ++i) w[i] += ws[i] * thetas[i];
+}
+
+void AddLaneMultiplesScalar(
+  double * const w,
+  const double * const ws,
+  const double c,
+  const int from,
+  const int n
+) noexcept
+{
+  for (int i=from; i!=n; ++i) w[i] += ws[i] * c;
+}
+
+#ifdef NEWICK_LANES_X86
+
+///Four lanes at a time, the lanes after the last four one by one
+__attribute__((target("avx2")))
+void DivideLanesByDenominatorsAvx2(
+  const double * const w,
+  const double d_0,
+  const double d_1,
+  const double * const thetas,
+  double * const ws,
+  const int n
+) noexcept
+{
+  const __m256d c_0 = _mm256_set1_pd(d_0);
+  const __m256d c_1 = _mm256_set1_pd(d_1);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d d = _mm256_add_pd(c_0, _mm256_mul_pd(c_1, _mm256_loadu_pd(thetas + i)));
+    _mm256_storeu_pd(ws + i, _mm256_div_pd(_mm256_loadu_pd(w + i), d));
+  }
+  DivideLanesByDenominatorsScalar(w, d_0, d_1, thetas, ws, i, n);
+}
+
+__attribute__((target("avx2")))
+void AddLaneProductsAvx2(
+  double * const w,
+  const double * const ws,
+  const double * const thetas,
+  const int n
+) noexcept
+{
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d p = _mm256_mul_pd(_mm256_loadu_pd(ws + i), _mm256_loadu_pd(thetas + i));
+    _mm256_storeu_pd(w + i, _mm256_add_pd(_mm256_loadu_pd(w + i), p));
+  }
+  AddLaneProductsScalar(w, ws, thetas, i, n);
+}
+
+__attribute__((target("avx2")))
+void AddLaneMultiplesAvx2(
+  double * const w,
+  const double * const ws,
+  const double c,
+  const int n
+) noexcept
+{
+  const __m256d m = _mm256_set1_pd(c);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d p = _mm256_mul_pd(_mm256_loadu_pd(ws + i), m);
+    _mm256_storeu_pd(w + i, _mm256_add_pd(_mm256_loadu_pd(w + i), p));
+  }
+  AddLaneMultiplesScalar(w, ws, c, i, n);
+}
+
+#endif // NEWICK_LANES_X86
+
+} //~namespace
+
+void ribi::newick::DivideLanesByDenominators(
+  const double * const w,
+  const double d_0,
+  const double d_1,
+  const double * const thetas,
+  double * const ws,
+  const int n,
+  const SimdLevel level
+) noexcept
+{
+  assert(n >= 0);
+  #ifdef NEWICK_LANES_X86
+  if (level == SimdLevel::avx2)
+  {
+    DivideLanesByDenominatorsAvx2(w, d_0, d_1, thetas, ws, n);
+    return;
+  }
+  #endif
+  (void)level;
+  DivideLanesByDenominatorsScalar(w, d_0, d_1, thetas, ws, 0, n);
+}
+
+void ribi::newick::AddLaneProducts(
+  double * const w,
+  const double * const ws,
+  const double * const thetas,
+  const int n,
+  const SimdLevel level
+) noexcept
+{
+  assert(n >= 0);
+  #ifdef NEWICK_LANES_X86
+  if (level == SimdLevel::avx2)
+  {
+    AddLaneProductsAvx2(w, ws, thetas, n);
+    return;
+  }
+  #endif
+  (void)level;
+  AddLaneProductsScalar(w, ws, thetas, 0, n);
+}
+
+void ribi::newick::AddLaneMultiples(
+  double * const w,
+  const double * const ws,
+  const double c,
+  const int n,
+  const SimdLevel level
+) noexcept
+{
+  assert(n >= 0);
+  #ifdef NEWICK_LANES_X86
+  if (level == SimdLevel::avx2)
+  {
+    AddLaneMultiplesAvx2(w, ws, c, n);
+    return;
+  }
+  #endif
+  (void)level;
+  AddLaneMultiplesScalar(w, ws, c, 0, n);
+}
@@ -0,0 +1,48 @@
+#ifndef NEWICKLANES_H
+#define NEWICKLANES_H
+
+#include "newickscanner.h"
+
+namespace ribi {
+namespace newick {
+
+///The lanes are the values per theta of CalculateProbabilities, stored
+///contiguously, so that each theta is a lane of the same loop.
+///The SIMD level must be supported by the CPU, see GetSimdLevel.
+///The AVX2 kernels do not fuse a multiply and an add,
+///so these round as the scalar loops do
+
+///DivideLanesByDenominators sets ws[i] to w[i] / (d_0 + (d_1 * thetas[i]))
+///for each of the n lanes
+void DivideLanesByDenominators(
+  const double * const w,
+  const double d_0,
+  const double d_1,
+  const double * const thetas,
+  double * const ws,
+  const int n,
+  const SimdLevel level
+) noexcept;
+
+///AddLaneProducts adds ws[i] * thetas[i] to w[i] for each of the n lanes
+void AddLaneProducts(
+  double * const w,
+  const double * const ws,
+  const double * const thetas,
+  const int n,
+  const SimdLevel level
+) noexcept;
+
+///AddLaneMultiples adds ws[i] * c to w[i] for each of the n lanes
+void AddLaneMultiples(
+  double * const w,
+  const double * const ws,
+  const double c,
+  const int n,
+  const SimdLevel level
+) noexcept;
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // NEWICKLANES_H
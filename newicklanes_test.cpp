@@ -0,0 +1,94 @@
+#include "newicklanes.h"
+
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+namespace {
+
+///All SIMD levels the CPU supports
+std::vector<SimdLevel> GetSupportedSimdLevels()
+{
+  std::vector<SimdLevel> v = { SimdLevel::scalar };
+  if (GetSimdLevel() == SimdLevel::sse2 || GetSimdLevel() == SimdLevel::avx2)
+  {
+    v.push_back(SimdLevel::sse2);
+  }
+  if (GetSimdLevel() == SimdLevel::avx2) v.push_back(SimdLevel::avx2);
+  return v;
+}
+
+} //~namespace
+
+BOOST_AUTO_TEST_CASE(ribi_newick_lanes)
+{
+  const std::vector<double> thetas = { 1.0, 2.0, 4.0, 8.0, 16.0 };
+  const std::vector<double> w = { 3.0, 6.0, 9.0, 12.0, 15.0 };
+  std::vector<double> ws(5, 0.0);
+  DivideLanesByDenominators(w.data(), 1.0, 0.5, thetas.data(), ws.data(), 5, GetSimdLevel());
+  const std::vector<double> expected_ws = { 2.0, 3.0, 3.0, 2.4, 15.0 / 9.0 };
+  std::vector<double> v(5, 1.0);
+  AddLaneProducts(v.data(), ws.data(), thetas.data(), 5, GetSimdLevel());
+  const std::vector<double> expected_products = { 3.0, 7.0, 13.0, 20.2, 1.0 + (16.0 * 15.0 / 9.0) };
+  std::vector<double> u(5, 1.0);
+  AddLaneMultiples(u.data(), w.data(), 2.0, 4, GetSimdLevel());
+  //Only the first four lanes are changed
+  const std::vector<double> expected_multiples = { 7.0, 13.0, 19.0, 25.0, 1.0 };
+  for (int i=0; i!=5; ++i)
+  {
+    BOOST_CHECK_CLOSE(ws[i], expected_ws[i], 1.0e-12);
+    BOOST_CHECK_CLOSE(v[i], expected_products[i], 1.0e-12);
+    BOOST_CHECK_EQUAL(u[i], expected_multiples[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_lanes_must_agree_for_all_simd_levels)
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> x(0.001, 1000.0);
+  for (int n=0; n!=40; ++n)
+  {
+    std::vector<double> thetas(n);
+    std::vector<double> w(n);
+    std::vector<double> initial(n);
+    for (int i=0; i!=n; ++i)
+    {
+      thetas[i] = x(rng);
+      w[i] = x(rng);
+      initial[i] = x(rng);
+    }
+    const double d_0 = x(rng);
+    const double d_1 = x(rng);
+    const double c = x(rng);
+    std::vector<double> expected_ws(n);
+    std::vector<double> expected_products(initial);
+    std::vector<double> expected_multiples(initial);
+    DivideLanesByDenominators(w.data(), d_0, d_1, thetas.data(), expected_ws.data(), n, SimdLevel::scalar);
+    AddLaneProducts(expected_products.data(), w.data(), thetas.data(), n, SimdLevel::scalar);
+    AddLaneMultiples(expected_multiples.data(), w.data(), c, n, SimdLevel::scalar);
+    for (const SimdLevel level: GetSupportedSimdLevels())
+    {
+      //Guard the lane after the last one, which must not be written
+      std::vector<double> ws(n + 1, -1.0);
+      std::vector<double> products(initial);
+      products.push_back(-1.0);
+      std::vector<double> multiples(initial);
+      multiples.push_back(-1.0);
+      DivideLanesByDenominators(w.data(), d_0, d_1, thetas.data(), ws.data(), n, level);
+      AddLaneProducts(products.data(), w.data(), thetas.data(), n, level);
+      AddLaneMultiples(multiples.data(), w.data(), c, n, level);
+      BOOST_CHECK_EQUAL(ws.back(), -1.0);
+      BOOST_CHECK_EQUAL(products.back(), -1.0);
+      BOOST_CHECK_EQUAL(multiples.back(), -1.0);
+      for (int i=0; i!=n; ++i)
+      {
+        BOOST_CHECK_CLOSE(ws[i], expected_ws[i], 1.0e-12);
+        BOOST_CHECK_CLOSE(products[i], expected_products[i], 1.0e-12);
+        BOOST_CHECK_CLOSE(multiples[i], expected_multiples[i], 1.0e-12);
+      }
+    }
+  }
+}
@@ -0,0 +1,204 @@
+#include "newickparallel.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <functional>
+#include <thread>
+
+#include "newick.h"
+#include "newickscanner.h"
+
+namespace {
+
+///The number of elements below which an extra thread does not pay off
+const std::size_t min_chunk_size = 1 << 16;
+
+///Get the number of chunks to split n_items into
+std::size_t GetNumberOfChunks(const std::size_t n_items, const int n_threads) noexcept
+{
+  assert(n_threads >= 0);
+  if (n_threads != 0)
+  {
+    return std::max(std::size_t(1), std::min(n_items, static_cast<std::size_t>(n_threads)));
+  }
+  const std::size_t n_cores = std::max(1u, std::thread::hardware_concurrency());
+  return std::max(std::size_t(1), std::min(n_cores, n_items / min_chunk_size));
+}
+
+///Calls f(chunk, begin, end) on each of the n_chunks chunks of n_items,
+///each in its own thread
+void ForEachChunk(
+  const std::size_t n_items,
+  const std::size_t n_chunks,
+  const std::function<void(std::size_t, std::size_t, std::size_t)>& f
+)
+{
+  if (n_chunks == 1)
+  {
+    f(0, 0, n_items);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (std::size_t i=0; i!=n_chunks; ++i)
+  {
+    const std::size_t begin = n_items * i / n_chunks;
+    const std::size_t end = n_items * (i + 1) / n_chunks;
+    threads.push_back(std::thread(f, i, begin, end));
+  }
+  for (std::thread& t: threads) t.join();
+}
+
+///Summarize the chunks of a Newick in parallel, and combine the summaries
+ribi::newick::NewickBracketBalance GetBracketBalanceParallel(
+  const std::size_t n_items,
+  const int n_threads,
+  const std::function<ribi::newick::NewickBracketBalance(std::size_t, std::size_t)>& f
+)
+{
+  const std::size_t n_chunks = GetNumberOfChunks(n_items, n_threads);
+  std::vector<ribi::newick::NewickBracketBalance> balances(n_chunks);
+  ForEachChunk(n_items, n_chunks,
+    [&balances, &f](const std::size_t chunk, const std::size_t begin, const std::size_t end)
+    {
+      balances[chunk] = f(begin, end);
+    }
+  );
+  ribi::newick::NewickBracketBalance total = { 0, 0 };
+  for (const auto& b: balances) total = ribi::newick::CombineBracketBalances(total, b);
+  return total;
+}
+
+} //~namespace
+
+ribi::newick::NewickBracketBalance ribi::newick::CombineBracketBalances(
+  const NewickBracketBalance& lhs,
+  const NewickBracketBalance& rhs
+) noexcept
+{
+  return {
+    lhs.balance + rhs.balance,
+    std::min(lhs.min_prefix, lhs.balance + rhs.min_prefix)
+  };
+}
+
+ribi::newick::NewickBracketBalance ribi::newick::GetBracketBalance(
+  const std::vector<int>& v,
+  const std::size_t begin,
+  const std::size_t end
+) noexcept
+{
+  assert(begin <= end);
+  assert(end <= v.size());
+  NewickBracketBalance b = { 0, 0 };
+  for (std::size_t i=begin; i!=end; ++i)
+  {
+    if (v[i] == bracket_open) ++b.balance;
+    else if (v[i] == bracket_close)
+    {
+      --b.balance;
+      b.min_prefix = std::min(b.min_prefix, b.balance);
+    }
+  }
+  return b;
+}
+
+ribi::newick::NewickBracketBalance ribi::newick::GetBracketBalance(
+  const std::string_view s) noexcept
+{
+  NewickBracketBalance b = { 0, 0 };
+  const SimdLevel level = GetSimdLevel();
+  for (std::size_t i=0; i<s.size(); i+=64)
+  {
+    const std::size_t n = std::min(s.size() - i, std::size_t(64));
+    const NewickBitmasks m = ClassifyNewickBlock(s.data() + i, n, level);
+    const int n_open = static_cast<int>(std::bitset<64>(m.bracket_open).count());
+    const int n_close = static_cast<int>(std::bitset<64>(m.bracket_close).count());
+    //Only if the block can set a new minimum, follow it bracket by bracket
+    if (b.balance - n_close < b.min_prefix)
+    {
+      std::uint64_t brackets = m.bracket_open | m.bracket_close;
+      int balance = b.balance;
+      while (brackets != 0)
+      {
+        const std::uint64_t bit = brackets & (~brackets + 1);
+        if (m.bracket_open & bit) ++balance;
+        else b.min_prefix = std::min(b.min_prefix, --balance);
+        brackets ^= bit;
+      }
+    }
+    b.balance += n_open - n_close;
+  }
+  return b;
+}
+
+std::vector<int> ribi::newick::GetDepthParallel(
+  const std::vector<int>& n,
+  const int n_threads
+)
+{
+  assert(IsNewick(n));
+  const std::size_t n_chunks = GetNumberOfChunks(n.size(), n_threads);
+
+  //Summarize each chunk
+  std::vector<NewickBracketBalance> balances(n_chunks);
+  ForEachChunk(n.size(), n_chunks,
+    [&balances, &n](const std::size_t chunk, const std::size_t begin, const std::size_t end)
+    {
+      balances[chunk] = GetBracketBalance(n, begin, end);
+    }
+  );
+
+  //The depth before each chunk is the prefix sum of the balances
+  std::vector<int> start_depths(n_chunks, -1);
+  for (std::size_t i=1; i!=n_chunks; ++i)
+  {
+    start_depths[i] = start_depths[i - 1] + balances[i - 1].balance;
+  }
+
+  //Fill in the depths of each chunk
+  std::vector<int> v(n.size());
+  ForEachChunk(n.size(), n_chunks,
+    [&start_depths, &n, &v](const std::size_t chunk, const std::size_t begin, const std::size_t end)
+    {
+      int depth = start_depths[chunk];
+      for (std::size_t i=begin; i!=end; ++i)
+      {
+        const int x = n[i];
+        if (x == bracket_open) ++depth;
+        v[i] = depth;
+        if (x == bracket_close) --depth;
+      }
+    }
+  );
+  assert(v == GetDepth(n));
+  return v;
+}
+
+bool ribi::newick::HasMatchingBracketsParallel(
+  const std::vector<int>& v,
+  const int n_threads
+)
+{
+  const NewickBracketBalance b = GetBracketBalanceParallel(v.size(), n_threads,
+    [&v](const std::size_t begin, const std::size_t end)
+    {
+      return GetBracketBalance(v, begin, end);
+    }
+  );
+  return b.balance == 0 && b.min_prefix >= 0;
+}
+
+bool ribi::newick::HasMatchingBracketsParallel(
+  const std::string_view s,
+  const int n_threads
+)
+{
+  const NewickBracketBalance b = GetBracketBalanceParallel(s.size(), n_threads,
+    [s](const std::size_t begin, const std::size_t end)
+    {
+      return GetBracketBalance(s.substr(begin, end - begin));
+    }
+  );
+  return b.balance == 0 && b.min_prefix >= 0;
+}
@@ -0,0 +1,63 @@
+#ifndef NEWICKPARALLEL_H
+#define NEWICKPARALLEL_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///NewickBracketBalance summarizes the brackets in a part of a Newick,
+///so that the parts can be summarized in parallel and combined after
+struct NewickBracketBalance
+{
+  ///The number of opening brackets minus the number of closing brackets
+  int balance;
+
+  ///The lowest balance after any element, zero if there are none
+  int min_prefix;
+};
+
+///CombineBracketBalances summarizes two consecutive parts of a Newick
+NewickBracketBalance CombineBracketBalances(
+  const NewickBracketBalance& lhs,
+  const NewickBracketBalance& rhs
+) noexcept;
+
+///GetBracketBalance summarizes the Newick elements from begin to end
+NewickBracketBalance GetBracketBalance(
+  const std::vector<int>& v,
+  const std::size_t begin,
+  const std::size_t end
+) noexcept;
+
+///GetBracketBalance summarizes the Newick characters in s
+NewickBracketBalance GetBracketBalance(const std::string_view s) noexcept;
+
+///GetDepthParallel returns the same as GetDepth, using n_threads threads.
+///If n_threads is zero, one thread per core is used,
+///unless the Newick is too small to benefit from this
+std::vector<int> GetDepthParallel(
+  const std::vector<int>& n,
+  const int n_threads = 0
+);
+
+///HasMatchingBracketsParallel returns true if each bracket has
+///a matching bracket, that is if the bracket balance never becomes
+///negative and ends at zero. Uses n_threads threads.
+///If n_threads is zero, one thread per core is used,
+///unless the Newick is too small to benefit from this
+bool HasMatchingBracketsParallel(
+  const std::vector<int>& v,
+  const int n_threads = 0
+);
+bool HasMatchingBracketsParallel(
+  const std::string_view s,
+  const int n_threads = 0
+);
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // NEWICKPARALLEL_H
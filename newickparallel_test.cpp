@@ -0,0 +1,78 @@
+#include "newickparallel.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_GetDepthParallel)
+{
+  for (const int n_leaves: { 2, 10, 1000 })
+  {
+    const std::vector<int> v{StringToNewick(CreateRandomNewick(n_leaves, 1000))};
+    const std::vector<int> expected{GetDepth(v)};
+    for (const int n_threads: { 0, 1, 2, 3, 8, 100000 })
+    {
+      BOOST_CHECK(GetDepthParallel(v, n_threads) == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_GetBracketBalance)
+{
+  const std::vector<int> v{StringToNewick("((1,2),(3,(4,5)))")};
+  const NewickBracketBalance all = GetBracketBalance(v, 0, v.size());
+  BOOST_CHECK_EQUAL(all.balance, 0);
+  BOOST_CHECK_EQUAL(all.min_prefix, 0);
+  //The closing brackets of '2),(3,(4,5)))'
+  const NewickBracketBalance tail = GetBracketBalance(v, 4, v.size());
+  BOOST_CHECK_EQUAL(tail.balance, -2);
+  BOOST_CHECK_EQUAL(tail.min_prefix, -2);
+  const NewickBracketBalance head = GetBracketBalance(v, 0, 4);
+  const NewickBracketBalance both = CombineBracketBalances(head, tail);
+  BOOST_CHECK_EQUAL(both.balance, all.balance);
+  BOOST_CHECK_EQUAL(both.min_prefix, all.min_prefix);
+
+  const NewickBracketBalance s = GetBracketBalance(std::string_view("))(1,2)(("));
+  BOOST_CHECK_EQUAL(s.balance, 0);
+  BOOST_CHECK_EQUAL(s.min_prefix, -2);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_HasMatchingBracketsParallel)
+{
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> c(0, 3);
+  for (int i=0; i!=1000; ++i)
+  {
+    //Strings of brackets, commas and ones, longer than a SIMD block
+    std::string s(1 + (i % 300), '1');
+    for (char& x: s) { x = "(),1"[c(rng)]; }
+    if (i % 2) s = "(" + CreateRandomNewick(10 + (i % 50), 10) + ")";
+
+    int balance = 0;
+    int min_prefix = 0;
+    for (const char x: s)
+    {
+      if (x == '(') ++balance;
+      if (x == ')') min_prefix = std::min(min_prefix, --balance);
+    }
+    const bool expected = balance == 0 && min_prefix == 0;
+    const NewickBracketBalance b = GetBracketBalance(std::string_view(s));
+    BOOST_CHECK_EQUAL(b.balance, balance);
+    BOOST_CHECK_EQUAL(b.min_prefix, min_prefix);
+    for (const int n_threads: { 0, 1, 3, 7 })
+    {
+      BOOST_CHECK_EQUAL(HasMatchingBracketsParallel(std::string_view(s), n_threads), expected);
+    }
+    if (expected && IsNewick(s))
+    {
+      BOOST_CHECK(HasMatchingBracketsParallel(StringToNewick(s), 3));
+    }
+  }
+  const std::vector<int> v{bracket_open, bracket_close, bracket_close, bracket_open};
+  BOOST_CHECK(!HasMatchingBracketsParallel(v, 2));
+}
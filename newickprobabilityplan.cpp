@@ -0,0 +1,286 @@
+#include "newickprobabilityplan.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include "newick.h"
+#include "newickhash.h"
+#include "smallnewick.h"
+
+namespace {
+
+///The probability of a simple Newick from its frequencies,
+///as CalcProbabilitySimpleNewick
+double CalcProbabilityOfFrequencies(
+  const int * const begin,
+  const int * const end,
+  const double theta) noexcept
+{
+  assert(begin != end);
+  int n=0;
+  int k=0;
+  double probability = 1.0;
+  for (const int * i = begin; i != end; ++i)
+  {
+    const int ni = *i;
+    assert(ni > 0);
+    ++k;
+    ++n;
+    for (int p=1; p!=ni; ++p, ++n)
+    {
+      probability *= (static_cast<double>(p)
+        / ( static_cast<double>(n) + theta));
+    }
+    probability /= ( static_cast<double>(n) + theta);
+  }
+  probability *= (static_cast<double>(n)+theta)
+    * std::pow(theta,static_cast<double>(k-1));
+  return probability;
+}
+
+///The linear factor 1 + (first / second) * theta, of which the fraction is reduced.
+///Each linear denominator is divided by its constant term, so that the
+///coefficients of the polynomials stay close to one
+typedef std::pair<std::int64_t, std::int64_t> Factor;
+
+///The factors of a denominator, with their multiplicities
+typedef std::map<Factor, int> Factors;
+
+///The coefficients of a polynomial in theta, from the constant term up
+typedef std::vector<long double> Polynomial;
+
+Factor CreateFactor(const std::int64_t numerator, const std::int64_t denominator) noexcept
+{
+  assert(numerator > 0);
+  assert(denominator > 0);
+  const std::int64_t gcd = std::gcd(numerator, denominator);
+  return Factor(numerator / gcd, denominator / gcd);
+}
+
+///Multiplies a polynomial by a factor
+void Multiply(Polynomial& p, const Factor& f)
+{
+  const long double r = static_cast<long double>(f.first)
+    / static_cast<long double>(f.second);
+  p.push_back(0.0L);
+  for (std::size_t i = p.size() - 1; i != 0; --i)
+  {
+    p[i] += r * p[i - 1];
+  }
+}
+
+} //~namespace
+
+ribi::newick::NewickProbabilityPlan::NewickProbabilityPlan(const std::vector<int>& n)
+  : m_denominator_constants{},
+    m_denominator_slopes{},
+    m_edges_begin(1, 0),
+    m_edge_frequencies{},
+    m_edge_targets{},
+    m_frequencies_begin(1, 0),
+    m_frequencies{}
+{
+  //The states are found level by level, as in CalculateProbabilityByLevels:
+  //each level holds the Newicks with the same sum of frequencies, per Size.
+  //A simpler Newick has either a lower sum, or the same sum and a lower Size,
+  //so the order in which the states are visited is topological.
+  //A level maps a Newick to the order in which it was found,
+  //which is converted to its state at the end
+  typedef std::unordered_map<SmallNewick, int, NewickHash> Map;
+  const SmallNewick root(GetCanonicalNewick(SmallNewick(n)));
+  const bool is_binary = IsBinaryNewick(root);
+  std::vector<Map> level(root.Size() + 1);
+  std::vector<Map> next_level(root.Size() + 1);
+  level[root.Size()][root] = 0;
+  int n_found = 1;
+  //The state of each Newick, in the order in which they were found
+  std::vector<int> states;
+  std::vector<std::pair<SmallNewick, int>> buffer;
+  while (1)
+  {
+    bool is_empty = true;
+    for (const Map& m: level) if (!m.empty()) is_empty = false;
+    if (is_empty) break;
+    for (int size = root.Size(); size != 0; --size)
+    {
+      for (const auto& q: level[size])
+      {
+        const SmallNewick& m = q.first;
+        states.resize(n_found);
+        states[q.second] = CountStates();
+        if (m.IsSimple())
+        {
+          for (const int x: m) if (x > 0) m_frequencies.push_back(x);
+          m_denominator_constants.push_back(0.0);
+          m_denominator_slopes.push_back(0.0);
+        }
+        else
+        {
+          //The denominator is linear in theta
+          const double d_0 = m.CalcDenominator(0.0);
+          m_denominator_constants.push_back(d_0);
+          m_denominator_slopes.push_back(m.CalcDenominator(1.0) - d_0);
+          if (is_binary)
+          {
+            GetSimplerBinaryNewicksFrequencyPairs(m, buffer);
+          }
+          else
+          {
+            GetSimplerNewicksFrequencyPairs(m, buffer);
+          }
+          for (const auto& r: buffer)
+          {
+            const SmallNewick newick(GetCanonicalNewick(r.first));
+            assert(r.second > 1 || newick.Size() < size);
+            Map& found = (r.second == 1 ? level : next_level)[newick.Size()];
+            const auto p = found.insert(std::make_pair(newick, n_found));
+            if (p.second) ++n_found;
+            m_edge_frequencies.push_back(r.second);
+            m_edge_targets.push_back(p.first->second);
+          }
+        }
+        m_edges_begin.push_back(CountEdges());
+        m_frequencies_begin.push_back(static_cast<int>(m_frequencies.size()));
+      }
+      level[size] = Map();
+    }
+    std::swap(level, next_level);
+  }
+  assert(static_cast<int>(states.size()) == CountStates());
+  for (int& target: m_edge_targets)
+  {
+    target = states[target];
+  }
+}
+
+double ribi::newick::NewickProbabilityPlan::CalculateProbability(const double theta) const
+{
+  const int n_states = CountStates();
+  std::vector<double> ps(n_states, 0.0);
+  for (int i = n_states - 1; i != -1; --i)
+  {
+    if (m_frequencies_begin[i] != m_frequencies_begin[i + 1])
+    {
+      ps[i] = CalcProbabilityOfFrequencies(
+        m_frequencies.data() + m_frequencies_begin[i],
+        m_frequencies.data() + m_frequencies_begin[i + 1],
+        theta
+      );
+      continue;
+    }
+    double p = 0.0;
+    const int end = m_edges_begin[i + 1];
+    for (int j = m_edges_begin[i]; j != end; ++j)
+    {
+      assert(m_edge_targets[j] > i);
+      const double f = static_cast<double>(m_edge_frequencies[j]);
+      const double coefficient = m_edge_frequencies[j] == 1 ? theta : f * (f - 1.0);
+      p += coefficient * ps[m_edge_targets[j]];
+    }
+    ps[i] = p / (m_denominator_constants[i] + (m_denominator_slopes[i] * theta));
+  }
+  return ps[0];
+}
+
+ribi::newick::NewickRationalFunction
+  ribi::newick::NewickProbabilityPlan::CalculateProbabilityFunction() const
+{
+  const int n_states = CountStates();
+  //The state that needs state i last, after which it is freed
+  std::vector<int> last_parents(n_states, 0);
+  for (int i = n_states - 1; i != -1; --i)
+  {
+    for (int j = m_edges_begin[i]; j != m_edges_begin[i + 1]; ++j)
+    {
+      last_parents[m_edge_targets[j]] = i;
+    }
+  }
+  std::vector<Polynomial> numerators(n_states);
+  std::vector<Factors> denominators(n_states);
+  for (int i = n_states - 1; i != -1; --i)
+  {
+    Polynomial& numerator = numerators[i];
+    Factors& denominator = denominators[i];
+    if (m_frequencies_begin[i] != m_frequencies_begin[i + 1])
+    {
+      //As CalcProbabilitySimpleNewick: theta^(k-1) times the product of
+      //(n_i - 1)! over the product of (m + theta) for m from 1 to the sum minus one,
+      //of which each (m + theta) is divided by m
+      int n=0;
+      int k=0;
+      long double scale = 1.0L;
+      for (int j = m_frequencies_begin[i]; j != m_frequencies_begin[i + 1]; ++j)
+      {
+        const int ni = m_frequencies[j];
+        ++k;
+        ++n;
+        for (int p=1; p!=ni; ++p, ++n)
+        {
+          scale *= static_cast<long double>(p) / static_cast<long double>(n);
+        }
+        scale /= static_cast<long double>(n);
+      }
+      scale *= static_cast<long double>(n);
+      numerator.assign(k, 0.0L);
+      numerator.back() = scale;
+      for (int m=1; m!=n; ++m) ++denominator[CreateFactor(1, m)];
+      continue;
+    }
+    //The denominator is the least common multiple of those of the simpler states,
+    //times the own denominator, which is added last
+    for (int j = m_edges_begin[i]; j != m_edges_begin[i + 1]; ++j)
+    {
+      for (const auto& q: denominators[m_edge_targets[j]])
+      {
+        int& multiplicity = denominator[q.first];
+        multiplicity = std::max(multiplicity, q.second);
+      }
+    }
+    const long double d_0 = static_cast<long double>(m_denominator_constants[i]);
+    assert(d_0 > 0.0L);
+    for (int j = m_edges_begin[i]; j != m_edges_begin[i + 1]; ++j)
+    {
+      const int target = m_edge_targets[j];
+      Polynomial term = numerators[target];
+      for (const auto& q: denominator)
+      {
+        const auto r = denominators[target].find(q.first);
+        const int missing = q.second - (r == denominators[target].end() ? 0 : r->second);
+        for (int m=0; m!=missing; ++m) Multiply(term, q.first);
+      }
+      const int f = m_edge_frequencies[j];
+      if (f == 1) term.insert(term.begin(), 0.0L);
+      const long double coefficient = f == 1
+        ? 1.0L / d_0
+        : static_cast<long double>(f) * static_cast<long double>(f - 1) / d_0;
+      if (numerator.size() < term.size()) numerator.resize(term.size(), 0.0L);
+      for (std::size_t m=0; m!=term.size(); ++m) numerator[m] += coefficient * term[m];
+    }
+    const double slope = m_denominator_slopes[i];
+    if (slope != 0.0)
+    {
+      ++denominator[CreateFactor(
+        static_cast<std::int64_t>(slope), static_cast<std::int64_t>(m_denominator_constants[i])
+      )];
+    }
+    for (int j = m_edges_begin[i]; j != m_edges_begin[i + 1]; ++j)
+    {
+      const int target = m_edge_targets[j];
+      if (last_parents[target] != i) continue;
+      numerators[target] = Polynomial();
+      denominators[target] = Factors();
+    }
+  }
+  Polynomial denominator(1, 1.0L);
+  for (const auto& q: denominators[0])
+  {
+    for (int m=0; m!=q.second; ++m) Multiply(denominator, q.first);
+  }
+  return NewickRationalFunction(numerators[0], denominator);
+}
@@ -0,0 +1,61 @@
+#ifndef NEWICKPROBABILITYPLAN_H
+#define NEWICKPROBABILITYPLAN_H
+
+#include <vector>
+
+#include "newickrationalfunction.h"
+
+namespace ribi {
+namespace newick {
+
+///NewickProbabilityPlan is the graph of all Newicks that can be derived
+///from a Newick, which does not depend on theta, built once into flat arrays.
+///The Newicks are states in topological order: each state comes before the
+///simpler states derived from it, the first state is the canonical Newick itself.
+///The simpler states of each state are a compressed sparse row of edges,
+///each with the frequency of GetSimplerNewicksFrequencyPairs.
+///CalculateProbability calculates the probability for any theta
+///in a single sweep over these arrays, from the last state to the first
+struct NewickProbabilityPlan
+{
+  ///Builds the plan of a valid Newick
+  explicit NewickProbabilityPlan(const std::vector<int>& n);
+
+  ///Calculates the same probability as CalculateProbability on the Newick
+  double CalculateProbability(const double theta) const;
+
+  ///Calculates the probability as a function of theta, which is a ratio of
+  ///two polynomials: the denominator is the product of the denominators
+  ///of the states, each a linear function of theta. Each state keeps its
+  ///numerator and the factors of its denominator until no state needs it.
+  ///This takes much more time than CalculateProbability,
+  ///so it is meant for the Newicks that are evaluated for many thetas
+  NewickRationalFunction CalculateProbabilityFunction() const;
+
+  ///The number of edges from a state to a simpler state
+  int CountEdges() const noexcept { return static_cast<int>(m_edge_targets.size()); }
+
+  ///The number of Newicks that can be derived from the Newick, including itself
+  int CountStates() const noexcept { return static_cast<int>(m_denominator_constants.size()); }
+
+  private:
+  ///Per state, the denominator is m_denominator_constants[i] + m_denominator_slopes[i] * theta
+  std::vector<double> m_denominator_constants;
+  std::vector<double> m_denominator_slopes;
+
+  ///The edges of state i are from m_edges_begin[i] to m_edges_begin[i + 1]
+  std::vector<int> m_edges_begin;
+  std::vector<int> m_edge_frequencies;
+  std::vector<int> m_edge_targets;
+
+  ///The frequencies of state i, if it is simple, are from
+  ///m_frequencies_begin[i] to m_frequencies_begin[i + 1].
+  ///A state that is not simple has no frequencies
+  std::vector<int> m_frequencies_begin;
+  std::vector<int> m_frequencies;
+};
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // NEWICKPROBABILITYPLAN_H
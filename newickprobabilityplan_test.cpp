@@ -0,0 +1,58 @@
+#include "newickprobabilityplan.h"
+
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickhash.h"
+#include "newickstorage.h"
+#include "smallnewick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_NewickProbabilityPlan)
+{
+  std::vector<std::string> newicks{
+    "(3)", "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))", "((20,2),3)"
+  };
+  for (int i=2; i!=8; ++i)
+  {
+    newicks.push_back(CreateRandomNewick(i, 3));
+  }
+  for (const std::string& s: newicks)
+  {
+    const NewickProbabilityPlan plan(StringToNewick(s));
+    BOOST_CHECK(plan.CountStates() > 0);
+    BOOST_CHECK(plan.CountEdges() >= plan.CountStates() - 1);
+    //A plan is reused for any theta
+    for (const double theta: { 0.1, 1.0, 10.0, 100.0 })
+    {
+      const SmallNewick n(StringToNewick(s));
+      ribi::NewickHashStorage<SmallNewick> storage(n);
+      BOOST_CHECK_CLOSE(plan.CalculateProbability(theta), CalculateProbability(n, theta, storage), 0.0001);
+    }
+  }
+  //Newicks of mixed arity use the general kernel
+  for (const std::string s: { "((1,2,3),(4,5))", "((4,5),(1,2,3))", "((1,2),(1,(1,2,1)))" })
+  {
+    const NewickProbabilityPlan plan(StringToNewick(s));
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    BOOST_CHECK_CLOSE(
+      plan.CalculateProbability(10.0),
+      CalculateProbabilityByArity<GeneralArityPolicy>(n, 10.0, storage),
+      0.0001
+    );
+  }
+  BOOST_CHECK_CLOSE(
+    NewickProbabilityPlan(StringToNewick("((1,2,3),(4,5))")).CalculateProbability(10.0),
+    7.5943e-13,
+    0.01
+  );
+  //Isomorphic Newicks have the same plan
+  BOOST_CHECK_EQUAL(
+    NewickProbabilityPlan(StringToNewick("((2,1),(1,2,3))")).CountStates(),
+    NewickProbabilityPlan(StringToNewick("((3,1,2),(1,2))")).CountStates()
+  );
+}
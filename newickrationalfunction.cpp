@@ -0,0 +1,95 @@
+#include "newickrationalfunction.h"
+
+#include <cassert>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+namespace {
+
+///Evaluates a polynomial with Horner's rule
+long double EvaluatePolynomial(
+  const std::vector<long double>& coefficients,
+  const long double x) noexcept
+{
+  long double y = 0.0L;
+  for (auto i = coefficients.rbegin(); i != coefficients.rend(); ++i)
+  {
+    y = (y * x) + *i;
+  }
+  return y;
+}
+
+///Writes the number of coefficients, followed by the coefficients
+void WritePolynomial(std::ostream& os, const std::vector<long double>& coefficients)
+{
+  os << coefficients.size();
+  for (const long double c: coefficients) os << ' ' << c;
+}
+
+///Reads what was written by WritePolynomial
+void ReadPolynomial(std::istream& is, std::vector<long double>& coefficients)
+{
+  std::size_t size = 0;
+  if (!(is >> size)) return;
+  coefficients.resize(size);
+  for (long double& c: coefficients)
+  {
+    if (!(is >> c)) return;
+  }
+}
+
+} //~namespace
+
+ribi::newick::NewickRationalFunction::NewickRationalFunction(
+  const std::vector<long double>& numerator,
+  const std::vector<long double>& denominator
+) : m_numerator{numerator},
+    m_denominator{denominator}
+{
+  assert(!m_denominator.empty());
+}
+
+double ribi::newick::NewickRationalFunction::Evaluate(const double theta) const noexcept
+{
+  const long double x = static_cast<long double>(theta);
+  return static_cast<double>(
+    EvaluatePolynomial(m_numerator, x) / EvaluatePolynomial(m_denominator, x)
+  );
+}
+
+bool ribi::newick::operator==(const NewickRationalFunction& lhs, const NewickRationalFunction& rhs) noexcept
+{
+  return lhs.GetNumerator() == rhs.GetNumerator()
+    && lhs.GetDenominator() == rhs.GetDenominator();
+}
+
+bool ribi::newick::operator!=(const NewickRationalFunction& lhs, const NewickRationalFunction& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+std::ostream& ribi::newick::operator<<(std::ostream& os, const NewickRationalFunction& f)
+{
+  const auto precision = os.precision(std::numeric_limits<long double>::max_digits10);
+  WritePolynomial(os, f.GetNumerator());
+  os << ' ';
+  WritePolynomial(os, f.GetDenominator());
+  os.precision(precision);
+  return os;
+}
+
+std::istream& ribi::newick::operator>>(std::istream& is, NewickRationalFunction& f)
+{
+  std::vector<long double> numerator;
+  std::vector<long double> denominator;
+  ReadPolynomial(is, numerator);
+  ReadPolynomial(is, denominator);
+  if (!is || denominator.empty())
+  {
+    is.setstate(std::ios::failbit);
+    return is;
+  }
+  f = NewickRationalFunction(numerator, denominator);
+  return is;
+}
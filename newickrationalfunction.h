@@ -0,0 +1,50 @@
+#ifndef NEWICKRATIONALFUNCTION_H
+#define NEWICKRATIONALFUNCTION_H
+
+#include <iosfwd>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///NewickRationalFunction is the probability of a Newick as a function of theta:
+///the ratio of two polynomials in theta, of which the coefficients are
+///stored in long double precision, from the constant term up.
+///It is created by NewickProbabilityPlan::CalculateProbabilityFunction.
+///All coefficients are non-negative, so that Evaluate (which uses Horner's rule)
+///does not suffer from cancellation for a positive theta
+struct NewickRationalFunction
+{
+  ///Creates a rational function from the coefficients of its numerator
+  ///and denominator, from the constant term up
+  NewickRationalFunction(
+    const std::vector<long double>& numerator,
+    const std::vector<long double>& denominator
+  );
+
+  ///Evaluates the function in time linear to its degree
+  double Evaluate(const double theta) const noexcept;
+
+  const std::vector<long double>& GetDenominator() const noexcept { return m_denominator; }
+  const std::vector<long double>& GetNumerator() const noexcept { return m_numerator; }
+
+  private:
+  std::vector<long double> m_numerator;
+  std::vector<long double> m_denominator;
+};
+
+bool operator==(const NewickRationalFunction& lhs, const NewickRationalFunction& rhs) noexcept;
+bool operator!=(const NewickRationalFunction& lhs, const NewickRationalFunction& rhs) noexcept;
+
+///Writes the coefficients in full precision, so that a NewickRationalFunction
+///read by operator>> is identical
+std::ostream& operator<<(std::ostream& os, const NewickRationalFunction& f);
+
+///Reads a NewickRationalFunction written by operator<<,
+///sets the failbit of is if it cannot be read
+std::istream& operator>>(std::istream& is, NewickRationalFunction& f);
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // NEWICKRATIONALFUNCTION_H
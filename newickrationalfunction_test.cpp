@@ -0,0 +1,63 @@
+#include "newickrationalfunction.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickprobabilityplan.h"
+#include "newickstorage.h"
+#include "smallnewick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_NewickRationalFunction)
+{
+  //'(1,1)' has a probability of theta / (1 + theta)
+  const NewickRationalFunction f{
+    NewickProbabilityPlan(StringToNewick("(1,1)")).CalculateProbabilityFunction()
+  };
+  BOOST_CHECK(f == NewickRationalFunction( { 0.0L, 1.0L }, { 1.0L, 1.0L } ));
+  BOOST_CHECK_CLOSE(f.Evaluate(10.0), 10.0 / 11.0, 0.0001);
+  BOOST_CHECK_CLOSE(
+    NewickProbabilityPlan(StringToNewick("((1,2,3),(4,5))")).CalculateProbabilityFunction().Evaluate(10.0),
+    7.5943e-13,
+    0.01
+  );
+
+  //Compared with the general kernel, as the plan could share a mistake
+  for (const std::string s: {
+    "(3)", "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))", "((5,2),3)",
+    "((1,2,3),(4,5))", "((4,5),(1,2,3))", "((1,2),(1,(1,2,1)))"
+  })
+  {
+    const NewickProbabilityPlan plan(StringToNewick(s));
+    const NewickRationalFunction g{plan.CalculateProbabilityFunction()};
+    const SmallNewick n(StringToNewick(s));
+    for (const double theta: { 0.1, 1.0, 10.0, 100.0 })
+    {
+      ribi::NewickStorage<SmallNewick> storage(n);
+      BOOST_CHECK_CLOSE(
+        g.Evaluate(theta),
+        CalculateProbabilityByArity<GeneralArityPolicy>(n, theta, storage),
+        0.0001
+      );
+    }
+    for (const long double c: g.GetNumerator()) BOOST_CHECK(c >= 0.0L);
+    for (const long double c: g.GetDenominator()) BOOST_CHECK(c >= 0.0L);
+
+    //Reads what is written
+    std::stringstream stream;
+    stream << g;
+    NewickRationalFunction h{ { 0.0L }, { 1.0L } };
+    stream >> h;
+    BOOST_CHECK(!stream.fail());
+    BOOST_CHECK(h == g);
+  }
+  std::stringstream stream("2 1.0");
+  NewickRationalFunction h{f};
+  stream >> h;
+  BOOST_CHECK(stream.fail());
+  BOOST_CHECK(h == f);
+}
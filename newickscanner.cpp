@@ -0,0 +1,140 @@
+#include "newickscanner.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define NEWICK_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+///Classify the n characters at p one by one
+ribi::newick::NewickBitmasks ClassifyNewickBlockScalar(
+  const char * const p,
+  const std::size_t n
+) noexcept
+{
+  ribi::newick::NewickBitmasks m = { 0, 0, 0, 0 };
+  for (std::size_t i=0; i!=n; ++i)
+  {
+    const char c = p[i];
+    const std::uint64_t bit = std::uint64_t(1) << i;
+    if (c == '(') m.bracket_open |= bit;
+    else if (c == ')') m.bracket_close |= bit;
+    else if (c == ',') m.comma |= bit;
+    else if (c >= '0' && c <= '9') m.digit |= bit;
+  }
+  return m;
+}
+
+#ifdef NEWICK_SCANNER_X86
+
+///Classify 64 characters at p, 16 at a time
+ribi::newick::NewickBitmasks ClassifyNewickBlockSse2(const char * const p) noexcept
+{
+  const __m128i open = _mm_set1_epi8('(');
+  const __m128i close = _mm_set1_epi8(')');
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  ribi::newick::NewickBitmasks m = { 0, 0, 0, 0 };
+  for (int i=0; i!=4; ++i)
+  {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + (16 * i)));
+    //A character is a digit if (c - '0') is at most nine, unsigned
+    const __m128i d = _mm_sub_epi8(x, zero);
+    const int shift = 16 * i;
+    m.bracket_open |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, open)))) << shift;
+    m.bracket_close |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, close)))) << shift;
+    m.comma |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, comma)))) << shift;
+    m.digit |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, nine), d)))) << shift;
+  }
+  return m;
+}
+
+///Classify 64 characters at p, 32 at a time
+__attribute__((target("avx2")))
+ribi::newick::NewickBitmasks ClassifyNewickBlockAvx2(const char * const p) noexcept
+{
+  const __m256i open = _mm256_set1_epi8('(');
+  const __m256i close = _mm256_set1_epi8(')');
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  ribi::newick::NewickBitmasks m = { 0, 0, 0, 0 };
+  for (int i=0; i!=2; ++i)
+  {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + (32 * i)));
+    //A character is a digit if (c - '0') is at most nine, unsigned
+    const __m256i d = _mm256_sub_epi8(x, zero);
+    const int shift = 32 * i;
+    m.bracket_open |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, open)))) << shift;
+    m.bracket_close |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, close)))) << shift;
+    m.comma |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, comma)))) << shift;
+    m.digit |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d)))) << shift;
+  }
+  return m;
+}
+
+#endif // NEWICK_SCANNER_X86
+
+} //~namespace
+
+ribi::newick::NewickBitmasks ribi::newick::ClassifyNewickBlock(
+  const char * const p,
+  const std::size_t n,
+  const SimdLevel level
+) noexcept
+{
+  assert(n <= 64);
+  //Partial blocks are classified one by one, so no
+  //character beyond p + n is read
+  if (n != 64) return ClassifyNewickBlockScalar(p, n);
+  switch (level)
+  {
+    #ifdef NEWICK_SCANNER_X86
+    case SimdLevel::avx2: return ClassifyNewickBlockAvx2(p);
+    case SimdLevel::sse2: return ClassifyNewickBlockSse2(p);
+    #endif
+    default: break;
+  }
+  return ClassifyNewickBlockScalar(p, n);
+}
+
+ribi::newick::SimdLevel ribi::newick::GetSimdLevel() noexcept
+{
+  #ifdef NEWICK_SCANNER_X86
+  static const SimdLevel level = __builtin_cpu_supports("avx2")
+    ? SimdLevel::avx2
+    : SimdLevel::sse2;
+  return level;
+  #else
+  return SimdLevel::scalar;
+  #endif
+}
+
+ribi::newick::NewickStructuralScanner::NewickStructuralScanner(
+  const std::string_view s,
+  const SimdLevel level
+) noexcept
+  : m_s{s},
+    m_level{level},
+    m_block{0},
+    m_next_block{0},
+    m_mask{0}
+{
+
+}
+
+void ribi::newick::NewickStructuralScanner::LoadBlock() noexcept
+{
+  assert(m_next_block < m_s.size());
+  const std::size_t n = std::min(m_s.size() - m_next_block, std::size_t(64));
+  const NewickBitmasks m = ClassifyNewickBlock(m_s.data() + m_next_block, n, m_level);
+  const std::uint64_t valid = n == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1;
+  m_mask = ~m.digit & valid;
+  m_block = m_next_block;
+  m_next_block += n;
+}
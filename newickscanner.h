@@ -0,0 +1,93 @@
+#ifndef NEWICKSCANNER_H
+#define NEWICKSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ribi {
+namespace newick {
+
+///NewickBitmasks classifies a block of at most 64 characters,
+///where bit i describes character i of the block
+struct NewickBitmasks
+{
+  std::uint64_t bracket_open;  //'('
+  std::uint64_t bracket_close; //')'
+  std::uint64_t comma;         //','
+  std::uint64_t digit;         //'0' to '9'
+};
+
+///The instruction set used to classify characters
+enum class SimdLevel { scalar, sse2, avx2 };
+
+///ClassifyNewickBlock classifies the n characters at p, where n is at most 64.
+///The bits at index n and beyond are zero.
+///The SIMD level must be supported by the CPU, see GetSimdLevel
+NewickBitmasks ClassifyNewickBlock(
+  const char * const p,
+  const std::size_t n,
+  const SimdLevel level
+) noexcept;
+
+///GetSimdLevel returns the best SIMD level the CPU supports,
+///as detected at runtime
+SimdLevel GetSimdLevel() noexcept;
+
+///NewickStructuralScanner iterates over the indices of the non-digit
+///characters in a string, which are the brackets, commas and
+///invalid characters. The characters are classified per block
+///of 64, using the best SIMD level the CPU supports
+struct NewickStructuralScanner
+{
+  explicit NewickStructuralScanner(
+    const std::string_view s,
+    const SimdLevel level = GetSimdLevel()
+  ) noexcept;
+
+  ///Next returns the index of the next non-digit character,
+  ///or the size of the string if there is none left
+  std::size_t Next() noexcept
+  {
+    while (m_mask == 0)
+    {
+      if (m_next_block >= m_s.size()) return m_s.size();
+      LoadBlock();
+    }
+    const std::size_t i = m_block + CountTrailingZeros(m_mask);
+    m_mask &= m_mask - 1;
+    return i;
+  }
+
+  private:
+  const std::string_view m_s;
+  const SimdLevel m_level;
+
+  ///The index of the current block
+  std::size_t m_block;
+
+  ///The index of the next block
+  std::size_t m_next_block;
+
+  ///The non-digit characters in the current block not yet returned
+  std::uint64_t m_mask;
+
+  ///Classify the next block
+  void LoadBlock() noexcept;
+
+  static int CountTrailingZeros(const std::uint64_t x) noexcept
+  {
+    #if defined(__GNUC__)
+    return __builtin_ctzll(x);
+    #else
+    int n = 0;
+    while (((x >> n) & 1) == 0) ++n;
+    return n;
+    #endif
+  }
+};
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // NEWICKSCANNER_H
@@ -0,0 +1,98 @@
+#include "newickscanner.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+namespace {
+
+///All SIMD levels the CPU supports
+std::vector<SimdLevel> GetSupportedSimdLevels()
+{
+  std::vector<SimdLevel> v = { SimdLevel::scalar };
+  if (GetSimdLevel() == SimdLevel::sse2 || GetSimdLevel() == SimdLevel::avx2)
+  {
+    v.push_back(SimdLevel::sse2);
+  }
+  if (GetSimdLevel() == SimdLevel::avx2) v.push_back(SimdLevel::avx2);
+  return v;
+}
+
+} //~namespace
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ClassifyNewickBlock)
+{
+  const std::string s{"(1,(23,4))x;(\xff"};
+  const NewickBitmasks m = ClassifyNewickBlock(s.data(), s.size(), SimdLevel::scalar);
+  //Bit i is character i, so the string reads from right to left
+  BOOST_CHECK_EQUAL(m.bracket_open,  0b01000000001001);
+  BOOST_CHECK_EQUAL(m.bracket_close, 0b00001100000000);
+  BOOST_CHECK_EQUAL(m.comma,         0b00000001000100);
+  BOOST_CHECK_EQUAL(m.digit,         0b00000010110010);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ClassifyNewickBlock_must_agree_for_all_simd_levels)
+{
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> c(0, 255);
+  std::uniform_int_distribution<int> structural(0, 12);
+  const std::string chars{"(),0123456789"};
+  for (int i=0; i!=1000; ++i)
+  {
+    std::string s(64, ' ');
+    for (char& x: s)
+    {
+      x = i % 2 ? static_cast<char>(c(rng)) : chars[structural(rng)];
+    }
+    const NewickBitmasks expected = ClassifyNewickBlock(s.data(), 64, SimdLevel::scalar);
+    for (const SimdLevel level: GetSupportedSimdLevels())
+    {
+      const NewickBitmasks m = ClassifyNewickBlock(s.data(), 64, level);
+      BOOST_CHECK_EQUAL(m.bracket_open, expected.bracket_open);
+      BOOST_CHECK_EQUAL(m.bracket_close, expected.bracket_close);
+      BOOST_CHECK_EQUAL(m.comma, expected.comma);
+      BOOST_CHECK_EQUAL(m.digit, expected.digit);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_NewickStructuralScanner)
+{
+  for (const SimdLevel level: GetSupportedSimdLevels())
+  {
+    for (const int n_leaves: { 2, 10, 100, 1000 })
+    {
+      const std::string s{CreateRandomNewick(n_leaves, 1000)};
+      std::vector<std::size_t> expected;
+      for (std::size_t i=0; i!=s.size(); ++i)
+      {
+        if (s[i] < '0' || s[i] > '9') expected.push_back(i);
+      }
+      std::vector<std::size_t> found;
+      NewickStructuralScanner scanner(s, level);
+      for (std::size_t i = scanner.Next(); i != s.size(); i = scanner.Next())
+      {
+        found.push_back(i);
+      }
+      BOOST_CHECK(found == expected);
+      BOOST_CHECK_EQUAL(scanner.Next(), s.size());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_IsNumberOrComma)
+{
+  for (int i=0; i!=256; ++i)
+  {
+    const char c = static_cast<char>(i);
+    BOOST_CHECK_EQUAL(
+      IsNumberOrComma(c),
+      std::string("0123456789,").find(c) != std::string::npos
+    );
+  }
+}
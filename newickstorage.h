@@ -33,27 +33,33 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace ribi {
 
-template <class NewickType>
+///NewickStorage stores the probabilities of Newicks, in a Map per Newick size.
+///Map is a std::map by default, use NewickHashStorage (in newickhash.h)
+///for a hash table. A probability is a double by default, or any mapped_type
+///of Map of which a default constructed value means unknown (see DualNumber)
+template <class NewickType, class Map = std::map<NewickType,double> >
 struct NewickStorage
 {
   typedef NewickType value_type;
+  typedef Map map_type;
+  typedef typename Map::mapped_type probability_type;
   NewickStorage(const NewickType& n);
-  double Find(const NewickType& n) const;
-  void Store(const NewickType& n, const double p);
-  const std::vector<std::map<NewickType,double> >& Peek() const { return m; }
+  probability_type Find(const NewickType& n) const;
+  void Store(const NewickType& n, const probability_type& p);
+  const std::vector<Map>& Peek() const { return m; }
   int CountNewicks() const;
   void CleanUp();
   int GetMemoryUse() const;
 
   private:
-  std::vector<std::map<NewickType,double> > m;
+  std::vector<Map> m;
 };
 
-template <class T, class U>
+template <class Map>
 const std::vector<int> GetSizes(
-  const std::vector<std::map<T,U> >& m)
+  const std::vector<Map>& m)
 {
-  typedef typename std::vector<std::map<T,U> >::const_iterator Iter;
+  typedef typename std::vector<Map>::const_iterator Iter;
 
   std::vector<int> v;
   v.reserve(m.size());
@@ -65,17 +71,17 @@ const std::vector<int> GetSizes(
   return v;
 }
 
-template <class T>
-NewickStorage<T>::NewickStorage(const T& n)
+template <class T, class Map>
+NewickStorage<T, Map>::NewickStorage(const T& n)
   : m(n.Size()+1)
 {
 
 }
 
-template <class T>
-double NewickStorage<T>::Find(const T& n) const
+template <class T, class Map>
+typename NewickStorage<T, Map>::probability_type NewickStorage<T, Map>::Find(const T& n) const
 {
-  typedef typename std::map<T,double>::const_iterator Iter;
+  typedef typename Map::const_iterator Iter;
   const int n_sz = n.Size();
   //Disallow resizing
   assert(n_sz < static_cast<int>(m.size()));
@@ -83,14 +89,14 @@ double NewickStorage<T>::Find(const T& n) const
   if (i!=m[n_sz].end())
   {
     //n is already known, return probability
-    assert((*i).second>0.0);
+    assert((*i).second != probability_type());
     return (*i).second;
   }
-  return 0.0;
+  return probability_type();
 }
 
-template <class T>
-void NewickStorage<T>::Store(const T& n, const double p)
+template <class T, class Map>
+void NewickStorage<T, Map>::Store(const T& n, const probability_type& p)
 {
   //TRACE("Stored probability for "
   //  + n.ToStr()
@@ -101,7 +107,7 @@ void NewickStorage<T>::Store(const T& n, const double p)
   //Disallow resizing
   assert(n_sz < static_cast<int>(m.size()));
 
-  assert(Find(n)==0.0 || Find(n)==p);
+  assert(Find(n)==probability_type() || Find(n)==p);
 
   while (1)
   {
@@ -129,8 +135,8 @@ void NewickStorage<T>::Store(const T& n, const double p)
   }
 }
 
-template <class T>
-int NewickStorage<T>::CountNewicks() const
+template <class T, class Map>
+int NewickStorage<T, Map>::CountNewicks() const
 {
   int sum = 0;
   const int sz = m.size();
@@ -141,8 +147,8 @@ int NewickStorage<T>::CountNewicks() const
   return sum;
 }
 
-template <class T>
-void NewickStorage<T>::CleanUp()
+template <class T, class Map>
+void NewickStorage<T, Map>::CleanUp()
 {
   //Clear the simplest std::maps,
   //  save the std::maps with most complex ones
@@ -165,7 +171,7 @@ void NewickStorage<T>::CleanUp()
       //All cleared except last
       break;
     }
-    m[i] = std::map<T,double>(); //Clear
+    m[i] = Map(); //Clear
   }
 }
 
@@ -177,8 +183,8 @@ void NewickStorage<T>::CleanUp()
 // the number of Newicks of that size
 // * the size of those Newicks
 // * the size of an integer
-template <class T>
-/* const */ int NewickStorage<T>::GetMemoryUse() const
+template <class T, class Map>
+/* const */ int NewickStorage<T, Map>::GetMemoryUse() const
 {
   std::vector<int> v = GetSizes(m);
   const int sz = v.size();
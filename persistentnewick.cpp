@@ -0,0 +1,412 @@
+#include "persistentnewick.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <set>
+
+#include "newick.h"
+#include "newickhash.h"
+
+///A frequency or a subtree
+struct ribi::newick::PersistentNewick::Node
+{
+  ///The frequency, zero for a subtree
+  int frequency;
+
+  ///The children of a subtree
+  std::vector<std::shared_ptr<const Node>> children;
+
+  ///The number of elements
+  int size;
+
+  ///The GetNewickHash of the elements
+  std::uint64_t hash;
+
+  ///newick_hash_base to the power of size
+  std::uint64_t power;
+
+  ///The sum of the frequencies
+  int sum;
+
+  ///The sum of the frequencies above one
+  int sum_above_one;
+
+  ///Are the children of this subtree and all its descendants sorted,
+  ///as done by CanonicalizeNewick?
+  bool is_canonical;
+};
+
+namespace {
+
+using Node = ribi::newick::PersistentNewick::Node;
+
+///Compares the elements of two nodes lexicographically,
+///returning a negative value, zero or a positive value
+int Compare(const Node& a, const Node& b) noexcept
+{
+  if (&a == &b) return 0;
+  //A frequency is positive, a subtree starts with a bracket_open
+  if (a.frequency != 0 && b.frequency != 0) return a.frequency - b.frequency;
+  if (a.frequency != 0) return 1;
+  if (b.frequency != 0) return -1;
+  //No complete subtree is the start of another, so the first
+  //pair of different children decides
+  const std::size_t sz = std::min(a.children.size(), b.children.size());
+  for (std::size_t i=0; i!=sz; ++i)
+  {
+    const int c = Compare(*a.children[i], *b.children[i]);
+    if (c != 0) return c;
+  }
+  //A bracket_close is less than the start of a frequency or subtree
+  return static_cast<int>(a.children.size()) - static_cast<int>(b.children.size());
+}
+
+std::shared_ptr<const Node> CreateLeaf(const int frequency)
+{
+  assert(frequency > 0);
+  return std::make_shared<const Node>(
+    Node{
+      frequency,
+      {},
+      1,
+      ribi::newick::GetNewickElementHash(frequency),
+      ribi::newick::newick_hash_base,
+      frequency,
+      frequency > 1 ? frequency : 0,
+      true
+    }
+  );
+}
+
+std::shared_ptr<const Node> CreateSubtree(
+  std::vector<std::shared_ptr<const Node>> children)
+{
+  using ribi::newick::GetNewickElementHash;
+  using ribi::newick::newick_hash_base;
+  assert(!children.empty());
+  int size = 2;
+  std::uint64_t hash = GetNewickElementHash(ribi::newick::bracket_open);
+  std::uint64_t power = newick_hash_base * newick_hash_base;
+  int sum = 0;
+  int sum_above_one = 0;
+  bool is_canonical = true;
+  for (std::size_t i=0; i!=children.size(); ++i)
+  {
+    const Node& child = *children[i];
+    size += child.size;
+    hash = hash * child.power + child.hash;
+    power *= child.power;
+    sum += child.sum;
+    sum_above_one += child.sum_above_one;
+    if (!child.is_canonical || (i != 0 && Compare(*children[i - 1], child) > 0))
+    {
+      is_canonical = false;
+    }
+  }
+  hash = hash * newick_hash_base + GetNewickElementHash(ribi::newick::bracket_close);
+  return std::make_shared<const Node>(
+    Node{ 0, std::move(children), size, hash, power, sum, sum_above_one, is_canonical }
+  );
+}
+
+///The path from the root to a node, as the nodes and the index of the child taken
+using Path = std::vector<std::pair<const Node *, std::size_t>>;
+
+///Creates a new root, in which the node at the end of the first
+///path_size steps of path is replaced by the node 'replacement'.
+///All nodes that are not on the path are shared
+std::shared_ptr<const Node> Replace(
+  const Path& path,
+  const std::size_t path_size,
+  std::shared_ptr<const Node> replacement)
+{
+  for (std::size_t i = path_size; i != 0; --i)
+  {
+    std::vector<std::shared_ptr<const Node>> children(path[i - 1].first->children);
+    children[path[i - 1].second] = std::move(replacement);
+    replacement = CreateSubtree(std::move(children));
+  }
+  return replacement;
+}
+
+///Collects all distinct nodes of a tree, skipping known subtrees
+void CollectNodes(const Node * const node, std::set<const Node *>& nodes)
+{
+  if (!nodes.insert(node).second) return;
+  for (const auto& child: node->children) CollectNodes(child.get(), nodes);
+}
+
+bool IsBinary(const Node& node) noexcept
+{
+  if (node.frequency != 0) return true;
+  return node.children.size() == 2 && IsBinary(*node.children[0]) && IsBinary(*node.children[1]);
+}
+
+std::shared_ptr<const Node> Canonicalize(const std::shared_ptr<const Node>& node)
+{
+  if (node->is_canonical) return node;
+  std::vector<std::shared_ptr<const Node>> children;
+  children.reserve(node->children.size());
+  for (const auto& child: node->children) children.push_back(Canonicalize(child));
+  std::stable_sort(std::begin(children), std::end(children),
+    [](const std::shared_ptr<const Node>& lhs, const std::shared_ptr<const Node>& rhs)
+    {
+      return Compare(*lhs, *rhs) < 0;
+    }
+  );
+  return CreateSubtree(std::move(children));
+}
+
+} //~namespace
+
+ribi::newick::PersistentNewick::PersistentNewick(const std::vector<int>& v)
+  : m_root{}
+{
+  assert(IsNewick(v));
+  //The children of each subtree that is not closed yet
+  std::vector<std::vector<std::shared_ptr<const Node>>> subtrees;
+  for (const int x: v)
+  {
+    if (x == bracket_open)
+    {
+      subtrees.push_back({});
+      continue;
+    }
+    std::shared_ptr<const Node> node;
+    if (x == bracket_close)
+    {
+      node = CreateSubtree(std::move(subtrees.back()));
+      subtrees.pop_back();
+    }
+    else
+    {
+      node = CreateLeaf(x);
+    }
+    if (subtrees.empty())
+    {
+      m_root = std::move(node);
+    }
+    else
+    {
+      subtrees.back().push_back(std::move(node));
+    }
+  }
+  assert(m_root);
+}
+
+ribi::newick::PersistentNewick::PersistentNewick(std::shared_ptr<const Node> root) noexcept
+  : m_root{std::move(root)}
+{
+
+}
+
+double ribi::newick::PersistentNewick::CalcDenominator(const double theta) const noexcept
+{
+  return static_cast<double>(m_root->sum * (m_root->sum - 1))
+    + (static_cast<double>(m_root->sum_above_one) * theta);
+}
+
+double ribi::newick::PersistentNewick::CalcProbabilitySimpleNewick(
+  const double theta
+) const noexcept
+{
+  assert(IsSimple());
+  int n=0;
+  int k=0;
+  double probability = 1.0;
+  for (const auto& child: m_root->children)
+  {
+    const int ni = child->frequency;
+    ++k;
+    ++n;
+    for (int p=1; p!=ni; ++p, ++n)
+    {
+      probability *= (static_cast<double>(p)
+        / ( static_cast<double>(n) + theta));
+    }
+    probability /= ( static_cast<double>(n) + theta);
+  }
+  probability *= (static_cast<double>(n)+theta)
+    * std::pow(theta,static_cast<double>(k-1));
+  return probability;
+}
+
+bool ribi::newick::PersistentNewick::IsSimple() const noexcept
+{
+  return std::all_of(
+    std::begin(m_root->children), std::end(m_root->children),
+    [](const std::shared_ptr<const Node>& child) { return child->frequency != 0; }
+  );
+}
+
+int ribi::newick::PersistentNewick::Size() const noexcept
+{
+  return m_root->size;
+}
+
+std::vector<int> ribi::newick::PersistentNewick::ToVector() const
+{
+  std::vector<int> v;
+  v.reserve(m_root->size);
+  Path path{ { m_root.get(), 0 } };
+  v.push_back(bracket_open);
+  while (!path.empty())
+  {
+    const Node * const node = path.back().first;
+    const std::size_t i = path.back().second;
+    if (i == node->children.size())
+    {
+      v.push_back(bracket_close);
+      path.pop_back();
+      continue;
+    }
+    ++path.back().second;
+    const Node * const child = node->children[i].get();
+    if (child->frequency != 0)
+    {
+      v.push_back(child->frequency);
+    }
+    else
+    {
+      v.push_back(bracket_open);
+      path.push_back(std::make_pair(child, 0));
+    }
+  }
+  assert(static_cast<int>(v.size()) == m_root->size);
+  return v;
+}
+
+bool ribi::newick::IsBinaryNewick(const PersistentNewick& n) noexcept
+{
+  return IsBinary(*n.GetRoot());
+}
+
+bool ribi::newick::IsUnaryNewick(const PersistentNewick& n) noexcept
+{
+  return n.Size() == 3;
+}
+
+bool ribi::newick::operator==(const PersistentNewick& lhs, const PersistentNewick& rhs) noexcept
+{
+  const auto& a = *lhs.GetRoot();
+  const auto& b = *rhs.GetRoot();
+  return a.hash == b.hash && a.size == b.size && Compare(a, b) == 0;
+}
+
+bool ribi::newick::operator!=(const PersistentNewick& lhs, const PersistentNewick& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+bool ribi::newick::operator<(const PersistentNewick& lhs, const PersistentNewick& rhs) noexcept
+{
+  return Compare(*lhs.GetRoot(), *rhs.GetRoot()) < 0;
+}
+
+std::size_t ribi::newick::CountNodes(const std::vector<PersistentNewick>& v)
+{
+  std::set<const Node *> nodes;
+  for (const auto& n: v) CollectNodes(n.GetRoot().get(), nodes);
+  return nodes.size();
+}
+
+ribi::newick::PersistentNewick ribi::newick::GetCanonicalNewick(const PersistentNewick& n)
+{
+  return PersistentNewick(Canonicalize(n.m_root));
+}
+
+std::uint64_t ribi::newick::GetNewickHash(const PersistentNewick& n) noexcept
+{
+  return n.GetRoot()->hash;
+}
+
+void ribi::newick::GetSimplerBinaryNewicksFrequencyPairs(
+  const PersistentNewick& n,
+  std::vector<std::pair<PersistentNewick, int>>& newicks
+)
+{
+  assert(IsBinaryNewick(n) || IsUnaryNewick(n));
+  GetSimplerNewicksFrequencyPairs(n, newicks);
+}
+
+std::vector<std::pair<ribi::newick::PersistentNewick, int>>
+  ribi::newick::GetSimplerNewicksFrequencyPairs(const PersistentNewick& n)
+{
+  std::vector<std::pair<PersistentNewick, int>> newicks;
+  GetSimplerNewicksFrequencyPairs(n, newicks);
+  return newicks;
+}
+
+void ribi::newick::GetSimplerNewicksFrequencyPairs(
+  const PersistentNewick& n,
+  std::vector<std::pair<PersistentNewick, int>>& newicks
+)
+{
+  //Visits the frequencies in the order of the Newick std::vector<int>,
+  //as GetSimplerNewicksFrequencyPairs on it does.
+  //Each step of path points to the child visited
+  newicks.clear();
+  Path path{ { n.m_root.get(), 0 } };
+  while (!path.empty())
+  {
+    const Node * const parent = path.back().first;
+    const std::size_t i = path.back().second;
+    if (i == parent->children.size())
+    {
+      path.pop_back();
+      if (!path.empty()) ++path.back().second;
+      continue;
+    }
+    const Node& child = *parent->children[i];
+    if (child.frequency == 0)
+    {
+      path.push_back(std::make_pair(&child, 0));
+      continue;
+    }
+    if (child.frequency > 1)
+    {
+      newicks.push_back(
+        std::make_pair(
+          PersistentNewick(Replace(path, path.size(), CreateLeaf(child.frequency - 1))),
+          child.frequency
+        )
+      );
+      ++path.back().second;
+      continue;
+    }
+    //Add the 1 to each sibling frequency, first those before it, nearest first,
+    //then those after it
+    const auto add_to = [&](const std::size_t j)
+    {
+      const auto sum = CreateLeaf(parent->children[j]->frequency + 1);
+      std::shared_ptr<const Node> root;
+      if (parent->children.size() == 2 && path.size() > 1)
+      {
+        //'((1,1),2)' -> '(2,2)'
+        root = Replace(path, path.size() - 1, sum);
+      }
+      else
+      {
+        std::vector<std::shared_ptr<const Node>> children;
+        children.reserve(parent->children.size() - 1);
+        for (std::size_t k=0; k!=parent->children.size(); ++k)
+        {
+          if (k == i) continue;
+          children.push_back(k == j ? sum : parent->children[k]);
+        }
+        root = Replace(path, path.size() - 1, CreateSubtree(std::move(children)));
+      }
+      newicks.push_back(std::make_pair(PersistentNewick(std::move(root)), 1));
+    };
+    for (std::size_t j = i; j != 0; --j)
+    {
+      if (parent->children[j - 1]->frequency != 0) add_to(j - 1);
+    }
+    for (std::size_t j = i + 1; j != parent->children.size(); ++j)
+    {
+      if (parent->children[j]->frequency != 0) add_to(j);
+    }
+    ++path.back().second;
+  }
+}
@@ -0,0 +1,113 @@
+#ifndef PERSISTENTNEWICK_H
+#define PERSISTENTNEWICK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///PersistentNewick is an immutable Newick tree of reference-counted nodes.
+///A simpler Newick derived from it shares each unchanged subtree with it:
+///only the nodes on the path from the root to the changed frequency
+///are created, which takes time and memory linear to the depth
+///(times the number of children per node) instead of to the size.
+///Each node keeps its size, GetNewickHash, sums of frequencies and
+///whether it is canonical, so that these take constant time.
+///It can be used as the NewickType of CalculateProbability and NewickStorage
+struct PersistentNewick
+{
+  struct Node;
+
+  ///Converts a valid Newick std::vector<int>
+  explicit PersistentNewick(const std::vector<int>& v);
+
+  ///Used by CalculateProbability
+  double CalcDenominator(const double theta) const noexcept;
+
+  ///Used by CalculateProbability, the Newick must be simple
+  double CalcProbabilitySimpleNewick(const double theta) const noexcept;
+
+  ///The root node, which is shared by all copies of this PersistentNewick
+  const std::shared_ptr<const Node>& GetRoot() const noexcept { return m_root; }
+
+  ///Used by CalculateProbability
+  bool IsSimple() const noexcept;
+
+  ///A PersistentNewick is its own tree, so Peek returns itself.
+  ///This lets CalculateProbability call the GetSimplerNewicksFrequencyPairs
+  ///overload on a PersistentNewick
+  const PersistentNewick& Peek() const noexcept { return *this; }
+
+  ///The number of elements of the Newick, used by NewickStorage
+  int Size() const noexcept;
+
+  ///Converts to a Newick std::vector<int>
+  std::vector<int> ToVector() const;
+
+  private:
+  explicit PersistentNewick(std::shared_ptr<const Node> root) noexcept;
+
+  std::shared_ptr<const Node> m_root;
+
+  friend PersistentNewick GetCanonicalNewick(const PersistentNewick& n);
+  friend void GetSimplerNewicksFrequencyPairs(
+    const PersistentNewick& n,
+    std::vector<std::pair<PersistentNewick, int>>& newicks
+  );
+};
+
+///IsBinaryNewick checks if each node of the Newick has two branches
+bool IsBinaryNewick(const PersistentNewick& n) noexcept;
+
+///IsUnaryNewick checks if the Newick is a single frequency, such as '(3)'
+bool IsUnaryNewick(const PersistentNewick& n) noexcept;
+
+bool operator==(const PersistentNewick& lhs, const PersistentNewick& rhs) noexcept;
+bool operator!=(const PersistentNewick& lhs, const PersistentNewick& rhs) noexcept;
+///Orders as the Newick std::vector<int>s do
+bool operator<(const PersistentNewick& lhs, const PersistentNewick& rhs) noexcept;
+
+///CountNodes returns the number of distinct nodes of the trees,
+///in which a node that is shared by multiple trees is counted once
+std::size_t CountNodes(const std::vector<PersistentNewick>& v);
+
+///GetCanonicalNewick returns the Newick with the children of each node sorted,
+///see CanonicalizeNewick. Only the nodes that are not canonical are created
+PersistentNewick GetCanonicalNewick(const PersistentNewick& n);
+
+///GetSimplerBinaryNewicksFrequencyPairs writes the simpler Newicks of a binary
+///(or unary) Newick and their frequencies to newicks. As the general
+///GetSimplerNewicksFrequencyPairs only visits the siblings of a frequency
+///in its own node, it is used for binary Newicks as well
+void GetSimplerBinaryNewicksFrequencyPairs(
+  const PersistentNewick& n,
+  std::vector<std::pair<PersistentNewick, int>>& newicks
+);
+
+///GetNewickHash returns the same hash as GetNewickHash on the Newick
+///std::vector<int>, in constant time
+std::uint64_t GetNewickHash(const PersistentNewick& n) noexcept;
+
+///GetSimplerNewicksFrequencyPairs creates simpler, derived Newicks from a Newick.
+///Its simpler Newicks and frequencies are identical to those created by
+///GetSimplerNewicksFrequencyPairs on the Newick std::vector<int>.
+///Each simpler Newick shares all subtrees with n, except for those on
+///the path from the root to the changed frequency
+std::vector<std::pair<PersistentNewick, int>>
+  GetSimplerNewicksFrequencyPairs(const PersistentNewick& n);
+
+///GetSimplerNewicksFrequencyPairs writes the simpler Newicks and their
+///frequencies to newicks, reusing its capacity
+void GetSimplerNewicksFrequencyPairs(
+  const PersistentNewick& n,
+  std::vector<std::pair<PersistentNewick, int>>& newicks
+);
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // PERSISTENTNEWICK_H
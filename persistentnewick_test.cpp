@@ -0,0 +1,125 @@
+#include "persistentnewick.h"
+
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickhash.h"
+#include "newickstorage.h"
+#include "smallnewick.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_PersistentNewick)
+{
+  const std::vector<int> v{StringToNewick("((1,2),3)")};
+  const PersistentNewick n(v);
+  BOOST_CHECK(n.ToVector() == v);
+  BOOST_CHECK_EQUAL(n.Size(), v.size());
+  BOOST_CHECK_EQUAL(GetNewickHash(n), GetNewickHash(v));
+  BOOST_CHECK(!n.IsSimple());
+  BOOST_CHECK_EQUAL(n.CalcDenominator(10.0), CalcDenominator(v, 10.0));
+  BOOST_CHECK(PersistentNewick(StringToNewick("(1,2)")).IsSimple());
+  BOOST_CHECK_CLOSE(
+    PersistentNewick(StringToNewick("(1,2,3)")).CalcProbabilitySimpleNewick(10.0),
+    CalcProbabilitySimpleNewick(StringToNewick("(1,2,3)"), 10.0),
+    0.0001
+  );
+  BOOST_CHECK(n == PersistentNewick(v));
+  BOOST_CHECK(n != PersistentNewick(StringToNewick("((1,2),4)")));
+  BOOST_CHECK(n < PersistentNewick(StringToNewick("((1,2),4)")));
+  BOOST_CHECK(IsBinaryNewick(n));
+  BOOST_CHECK(!IsBinaryNewick(PersistentNewick(StringToNewick("((1,2),3,4)"))));
+  BOOST_CHECK(IsUnaryNewick(PersistentNewick(StringToNewick("(3)"))));
+
+  //Orders as the Newick std::vector<int>s do
+  std::vector<std::string> newicks{CreateValidNewicks()};
+  for (const std::string& s: newicks)
+  {
+    for (const std::string& t: newicks)
+    {
+      BOOST_CHECK_EQUAL(
+        PersistentNewick(StringToNewick(s)) < PersistentNewick(StringToNewick(t)),
+        StringToNewick(s) < StringToNewick(t)
+      );
+    }
+    BOOST_CHECK(
+      GetCanonicalNewick(PersistentNewick(StringToNewick(s))).ToVector()
+      == GetCanonicalNewick(StringToNewick(s))
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_PersistentNewick_GetSimplerNewicksFrequencyPairs)
+{
+  std::vector<std::string> newicks{CreateValidNewicks()};
+  for (int i=2; i!=30; ++i)
+  {
+    newicks.push_back(CreateRandomNewick(i, 3));
+  }
+  for (const std::string& s: newicks)
+  {
+    const std::vector<int> v{StringToNewick(s)};
+    const auto expected = GetSimplerNewicksFrequencyPairs(v);
+    const auto simpler = GetSimplerNewicksFrequencyPairs(PersistentNewick(v));
+    BOOST_REQUIRE_EQUAL(simpler.size(), expected.size());
+    for (std::size_t i=0; i!=simpler.size(); ++i)
+    {
+      BOOST_CHECK(simpler[i].first.ToVector() == expected[i].first);
+      BOOST_CHECK_EQUAL(simpler[i].second, expected[i].second);
+      BOOST_CHECK_EQUAL(GetNewickHash(simpler[i].first), GetNewickHash(expected[i].first));
+      BOOST_CHECK_EQUAL(simpler[i].first.Size(), expected[i].first.size());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_PersistentNewick_shares_subtrees)
+{
+  //Only the path to the changed frequency is created:
+  //'(2,(1,1)),((1,1),(1,1))' has 13 nodes, of which
+  //'(1,(1,1)),((1,1),(1,1))' shares all but the root, the first child and its frequency
+  const PersistentNewick n(StringToNewick("((2,(1,1)),((1,1),(1,1)))"));
+  const auto simpler = GetSimplerNewicksFrequencyPairs(n);
+  BOOST_REQUIRE(!simpler.empty());
+  BOOST_CHECK(simpler[0].first.ToVector() == StringToNewick("((1,(1,1)),((1,1),(1,1)))"));
+  BOOST_CHECK_EQUAL(CountNodes( { n } ), 13);
+  BOOST_CHECK_EQUAL(CountNodes( { n, simpler[0].first } ), 13 + 3);
+
+  //A canonical Newick is not copied
+  const PersistentNewick c{GetCanonicalNewick(n)};
+  BOOST_CHECK(GetCanonicalNewick(c).GetRoot() == c.GetRoot());
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_PersistentNewick_CalculateProbability)
+{
+  for (const std::string s: { "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))" })
+  {
+    const PersistentNewick n(StringToNewick(s));
+    const SmallNewick m(StringToNewick(s));
+    ribi::NewickStorage<PersistentNewick> storage(n);
+    ribi::NewickHashStorage<PersistentNewick> hash_storage(n);
+    ribi::NewickStorage<SmallNewick> small_storage(m);
+    const double p = CalculateProbability(m, 10.0, small_storage);
+    BOOST_CHECK_CLOSE(CalculateProbability(n, 10.0, storage), p, 0.0001);
+    BOOST_CHECK_CLOSE(CalculateProbability(n, 10.0, hash_storage), p, 0.0001);
+    BOOST_CHECK_EQUAL(storage.CountNewicks(), small_storage.CountNewicks());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CalculateProbability_deep)
+{
+  //Each simpler Newick of '((n,1),1)' is a Newick of about the same
+  //depth of simpler Newicks, so the calculation is n Newicks deep
+  const std::vector<int> v{StringToNewick("((2000,1),1)")};
+  const SmallNewick n(v);
+  const PersistentNewick m(v);
+  ribi::NewickHashStorage<SmallNewick> storage(n);
+  ribi::NewickHashStorage<PersistentNewick> persistent_storage(m);
+  const double p = CalculateProbability(n, 10.0, storage);
+  BOOST_CHECK(p > 0.0);
+  BOOST_CHECK(p < 1.0);
+  BOOST_CHECK_CLOSE(CalculateProbability(m, 10.0, persistent_storage), p, 0.0001);
+  BOOST_CHECK_EQUAL(storage.Find(GetCanonicalNewick(n)), p);
+  BOOST_CHECK_EQUAL(storage.CountNewicks(), persistent_storage.CountNewicks());
+}
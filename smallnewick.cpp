@@ -0,0 +1,335 @@
+#include "smallnewick.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include "newick.h"
+#include "newickhash.h"
+
+ribi::newick::SmallNewick::SmallNewick() noexcept
+  : m_inline{},
+    m_heap{},
+    m_hash{0},
+    m_size{0}
+{
+
+}
+
+ribi::newick::SmallNewick::SmallNewick(const std::vector<int>& v)
+  : m_inline{},
+    m_heap{},
+    m_hash{GetNewickHash(v)},
+    m_size{static_cast<int>(v.size())}
+{
+  assert(IsNewick(v));
+  if (IsHeapAllocated())
+  {
+    m_heap = v;
+  }
+  else
+  {
+    std::copy(std::begin(v), std::end(v), std::begin(m_inline));
+  }
+}
+
+double ribi::newick::SmallNewick::CalcDenominator(const double theta) const noexcept
+{
+  int sum_above_zero = 0;
+  int sum_above_one  = 0;
+  for (const int i: *this)
+  {
+    if (i > 0) sum_above_zero += i;
+    if (i > 1) sum_above_one  += i;
+  }
+  return static_cast<double>(sum_above_zero * (sum_above_zero - 1))
+    + (static_cast<double>(sum_above_one) * theta);
+}
+
+double ribi::newick::SmallNewick::CalcProbabilitySimpleNewick(
+  const double theta
+) const noexcept
+{
+  assert(IsSimple());
+  int n=0;
+  int k=0;
+  double probability = 1.0;
+  for (const int ni: *this)
+  {
+    if (ni <= 0) continue;
+    ++k;
+    ++n;
+    for (int p=1; p!=ni; ++p, ++n)
+    {
+      probability *= (static_cast<double>(p)
+        / ( static_cast<double>(n) + theta));
+    }
+    probability /= ( static_cast<double>(n) + theta);
+  }
+  probability *= (static_cast<double>(n)+theta)
+    * std::pow(theta,static_cast<double>(k-1));
+  return probability;
+}
+
+const int * ribi::newick::SmallNewick::data() const noexcept
+{
+  return IsHeapAllocated() ? m_heap.data() : m_inline.data();
+}
+
+int * ribi::newick::SmallNewick::data() noexcept
+{
+  return IsHeapAllocated() ? m_heap.data() : m_inline.data();
+}
+
+bool ribi::newick::SmallNewick::IsSimple() const noexcept
+{
+  //A Newick is simple if it contains no '(' after the initial one
+  return std::count(begin() + 1, end(), static_cast<int>(bracket_open)) == 0;
+}
+
+void ribi::newick::SmallNewick::PushBack(const int x)
+{
+  if (m_size < inline_capacity)
+  {
+    m_inline[m_size] = x;
+  }
+  else
+  {
+    if (m_size == inline_capacity)
+    {
+      m_heap.reserve(2 * inline_capacity);
+      m_heap.assign(std::begin(m_inline), std::end(m_inline));
+    }
+    m_heap.push_back(x);
+  }
+  ++m_size;
+}
+
+std::vector<int> ribi::newick::SmallNewick::ToVector() const
+{
+  return std::vector<int>(begin(), end());
+}
+
+bool ribi::newick::IsBinaryNewick(const SmallNewick& n)
+{
+  return IsBinaryNewick(n.ToVector());
+}
+
+bool ribi::newick::IsUnaryNewick(const SmallNewick& n) noexcept
+{
+  return n.Size() == 3;
+}
+
+bool ribi::newick::operator==(const SmallNewick& lhs, const SmallNewick& rhs) noexcept
+{
+  if (GetNewickHash(lhs) != GetNewickHash(rhs)) return false;
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+bool ribi::newick::operator!=(const SmallNewick& lhs, const SmallNewick& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+bool ribi::newick::operator<(const SmallNewick& lhs, const SmallNewick& rhs) noexcept
+{
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+ribi::newick::SmallNewick ribi::newick::GetCanonicalNewick(const SmallNewick& n)
+{
+  SmallNewick m(n);
+  if (CanonicalizeNewick(m.data(), m.data() + m.Size()))
+  {
+    m.m_hash = GetNewickHash(m.begin(), m.end());
+  }
+  return m;
+}
+
+std::uint64_t ribi::newick::GetNewickHash(const SmallNewick& n) noexcept
+{
+  assert(n.m_hash == GetNewickHash(n.begin(), n.end()));
+  return n.m_hash;
+}
+
+std::vector<std::pair<ribi::newick::SmallNewick, int>>
+  ribi::newick::GetSimplerNewicksFrequencyPairs(const SmallNewick& n)
+{
+  std::vector<std::pair<SmallNewick, int>> newicks;
+  //Most frequencies give one simpler Newick
+  newicks.reserve(std::count_if(n.begin(), n.end(), [](const int x) { return x > 0; }));
+  GetSimplerNewicksFrequencyPairs(n, newicks);
+  return newicks;
+}
+
+void ribi::newick::GetSimplerNewicksFrequencyPairs(
+  const SmallNewick& n,
+  std::vector<std::pair<SmallNewick, int>>& newicks
+)
+{
+  SmallNewick::GetSimplerNewicksFrequencyPairs<false>(n, newicks);
+}
+
+void ribi::newick::GetSimplerBinaryNewicksFrequencyPairs(
+  const SmallNewick& n,
+  std::vector<std::pair<SmallNewick, int>>& newicks
+)
+{
+  assert(IsBinaryNewick(n) || IsUnaryNewick(n));
+  SmallNewick::GetSimplerNewicksFrequencyPairs<true>(n, newicks);
+}
+
+template <bool is_binary>
+void ribi::newick::SmallNewick::GetSimplerNewicksFrequencyPairs(
+  const SmallNewick& n,
+  std::vector<std::pair<SmallNewick, int>>& newicks
+)
+{
+  //Follows NewickCpp98::GetSimplerNewicksFrequencyPairs,
+  //writing each simpler Newick directly instead of via copies
+  newicks.clear();
+  const int size = n.Size();
+
+  //The depths (not needed for a binary Newick), the hashes of the prefixes
+  //of n and the powers of the hash base, on the heap only if n is
+  std::array<int, SmallNewick::inline_capacity> inline_depths;
+  std::array<std::uint64_t, SmallNewick::inline_capacity + 1> inline_prefix_hashes;
+  std::array<std::uint64_t, SmallNewick::inline_capacity + 1> inline_powers;
+  std::vector<int> heap_depths;
+  std::vector<std::uint64_t> heap_prefix_hashes;
+  std::vector<std::uint64_t> heap_powers;
+  if (n.IsHeapAllocated())
+  {
+    if (!is_binary) heap_depths.resize(size);
+    heap_prefix_hashes.resize(size + 1);
+    heap_powers.resize(size + 1);
+  }
+  int * const depths = n.IsHeapAllocated() ? heap_depths.data() : inline_depths.data();
+  std::uint64_t * const prefix_hashes = n.IsHeapAllocated()
+    ? heap_prefix_hashes.data() : inline_prefix_hashes.data();
+  std::uint64_t * const powers = n.IsHeapAllocated()
+    ? heap_powers.data() : inline_powers.data();
+  {
+    int depth = -1;
+    prefix_hashes[0] = 0;
+    powers[0] = 1;
+    for (int i=0; i!=size; ++i)
+    {
+      if (!is_binary)
+      {
+        if (n[i] == bracket_open) ++depth;
+        depths[i] = depth;
+        if (n[i] == bracket_close) --depth;
+      }
+      prefix_hashes[i + 1] = prefix_hashes[i] * newick_hash_base + GetNewickElementHash(n[i]);
+      powers[i + 1] = powers[i] * newick_hash_base;
+    }
+  }
+  assert(prefix_hashes[size] == GetNewickHash(n));
+  //The hash of the elements of n in [from,to)
+  const auto get_hash = [prefix_hashes, powers](const int from, const int to)
+  {
+    return prefix_hashes[to] - prefix_hashes[from] * powers[to - from];
+  };
+  //The change of the hash when frequency f is changed by delta,
+  //with n_after elements after it
+  const auto get_delta = [powers](const int f, const int delta, const int n_after)
+  {
+    return powers[n_after] * (GetNewickElementHash(f + delta) - GetNewickElementHash(f));
+  };
+  //Add the 1 at index i to the frequency at index j
+  const auto add_to = [&n, &newicks, size, get_hash, get_delta, powers](const int i, const int j)
+  {
+    //If the 1 is added to its only neighbour, remove both brackets:
+    //'((1,1),2)' -> '(2,2)'
+    int index_bracket_open  = -1;
+    int index_bracket_close = -1;
+    if (std::abs(i - j) == 1
+      && n[std::min(i,j) - 1] == bracket_open
+      && n[std::max(i,j) + 1] == bracket_close)
+    {
+      index_bracket_open  = std::min(i,j) - 1;
+      index_bracket_close = std::max(i,j) + 1;
+    }
+    //Add brackets if these are removed
+    const bool surround = index_bracket_open == 0 && index_bracket_close == size - 1;
+    SmallNewick new_newick;
+    if (surround) new_newick.PushBack(bracket_open);
+    for (int k=0; k!=size; ++k)
+    {
+      if (k == i || k == index_bracket_open || k == index_bracket_close) continue;
+      new_newick.PushBack(k == j ? n[k] + 1 : n[k]);
+    }
+    if (surround) new_newick.PushBack(bracket_close);
+    assert(IsNewick(new_newick.ToVector()));
+
+    //The hash of n without the elements removed, which are in increasing order.
+    //If the brackets are added again, only i is removed
+    std::array<int, 3> removed{ { i, size, size } };
+    if (index_bracket_open != -1 && !surround)
+    {
+      removed = { { index_bracket_open, i, index_bracket_close } };
+    }
+    std::uint64_t hash = 0;
+    int from = 0;
+    int n_removed_after_j = 0;
+    for (const int r: removed)
+    {
+      if (r == size) break;
+      hash = hash * powers[r - from] + get_hash(from, r);
+      from = r + 1;
+      if (r > j) ++n_removed_after_j;
+    }
+    hash = hash * powers[size - from] + get_hash(from, size);
+    new_newick.m_hash = hash + get_delta(n[j], 1, size - 1 - j - n_removed_after_j);
+    assert(new_newick.m_hash == GetNewickHash(new_newick.begin(), new_newick.end()));
+    newicks.push_back(std::make_pair(std::move(new_newick), 1));
+  };
+
+  for (int i = 0; i!=size; ++i)
+  {
+    if (n[i] < 1) continue;
+    if (n[i] > 1)
+    {
+      newicks.push_back(std::make_pair(n, n[i]));
+      SmallNewick& new_newick = newicks.back().first;
+      --new_newick.data()[i];
+      new_newick.m_hash += get_delta(n[i], -1, size - 1 - i);
+      assert(new_newick.m_hash == GetNewickHash(new_newick.begin(), new_newick.end()));
+      continue;
+    }
+    assert(n[i] == 1); //Most difficult...
+    if (is_binary)
+    {
+      //The only sibling of the 1 is its neighbour, if that is a frequency
+      const int j = n[i - 1] > 0 ? i - 1 : i + 1;
+      if (n[j] > 0) add_to(i, j);
+      continue;
+    }
+    const int depth = depths[i];
+    //j must first decrement, later increment with the same code
+    int j_end  = -1;
+    int j_step = -1;
+    for (int j=i-1; ; j+=j_step)
+    {
+      if (j == j_end || (depths[j] == depth && n[j] < 0))
+      {
+        if (j_step == -1)
+        {
+          j = i + 1;
+          j_end = size;
+          j_step = 1;
+        }
+        else
+        {
+          break;
+        }
+      }
+      assert(i!=j);
+      //Only take frequencies of the same depth into account
+      if (n[j] < 1 || depths[j] != depth) continue;
+      add_to(i, j);
+    }
+  }
+}
@@ -0,0 +1,148 @@
+#ifndef SMALLNEWICK_H
+#define SMALLNEWICK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///SmallNewick is a Newick that stores up to inline_capacity
+///elements (brackets and frequencies) in itself, and only
+///uses the heap for bigger Newicks.
+///It can be used as the NewickType of CalculateProbability
+///and NewickStorage, in which its simpler Newicks are created
+///without a heap allocation per simpler Newick.
+///It keeps its GetNewickHash, which is derived in constant time
+///for its simpler Newicks
+struct SmallNewick
+{
+  ///The number of elements that are stored without a heap allocation
+  static constexpr int inline_capacity = 32;
+
+  ///Copies a valid Newick std::vector<int>
+  explicit SmallNewick(const std::vector<int>& v);
+
+  const int * begin() const noexcept { return data(); }
+  const int * end() const noexcept { return data() + m_size; }
+
+  ///Used by CalculateProbability
+  double CalcDenominator(const double theta) const noexcept;
+
+  ///Used by CalculateProbability, the Newick must be simple
+  double CalcProbabilitySimpleNewick(const double theta) const noexcept;
+
+  ///Are the elements stored on the heap?
+  bool IsHeapAllocated() const noexcept { return m_size > inline_capacity; }
+
+  ///Used by CalculateProbability
+  bool IsSimple() const noexcept;
+
+  ///A SmallNewick is its own sequence of elements, so Peek returns itself.
+  ///This lets CalculateProbability call the GetSimplerNewicksFrequencyPairs
+  ///overload on a SmallNewick
+  const SmallNewick& Peek() const noexcept { return *this; }
+
+  ///The number of elements of the Newick, used by NewickStorage
+  int Size() const noexcept { return m_size; }
+
+  ///Copies the Newick to a std::vector<int>
+  std::vector<int> ToVector() const;
+
+  int operator[](const int i) const noexcept { return data()[i]; }
+
+  private:
+  ///Creates an empty SmallNewick, which is not a valid Newick
+  SmallNewick() noexcept;
+
+  ///The elements, if there are at most inline_capacity
+  std::array<int, inline_capacity> m_inline;
+
+  ///The elements, if there are more than inline_capacity
+  std::vector<int> m_heap;
+
+  ///The GetNewickHash of the elements
+  std::uint64_t m_hash;
+
+  int m_size;
+
+  const int * data() const noexcept;
+  int * data() noexcept;
+
+  ///Appends an element, moving all elements to the heap
+  ///if there are more than inline_capacity
+  void PushBack(const int x);
+
+  friend SmallNewick GetCanonicalNewick(const SmallNewick& n);
+  friend std::uint64_t GetNewickHash(const SmallNewick& n) noexcept;
+  ///Writes the simpler Newicks of n to newicks. If is_binary,
+  ///n must be binary or unary, so that a frequency of one
+  ///is only added to its neighbour
+  template <bool is_binary>
+  static void GetSimplerNewicksFrequencyPairs(
+    const SmallNewick& n,
+    std::vector<std::pair<SmallNewick, int>>& newicks
+  );
+
+  friend void GetSimplerBinaryNewicksFrequencyPairs(
+    const SmallNewick& n,
+    std::vector<std::pair<SmallNewick, int>>& newicks
+  );
+  friend void GetSimplerNewicksFrequencyPairs(
+    const SmallNewick& n,
+    std::vector<std::pair<SmallNewick, int>>& newicks
+  );
+};
+
+///IsBinaryNewick checks if each node of the Newick has two branches
+bool IsBinaryNewick(const SmallNewick& n);
+
+///IsUnaryNewick checks if the Newick is a single frequency, such as '(3)'
+bool IsUnaryNewick(const SmallNewick& n) noexcept;
+
+bool operator==(const SmallNewick& lhs, const SmallNewick& rhs) noexcept;
+bool operator!=(const SmallNewick& lhs, const SmallNewick& rhs) noexcept;
+bool operator<(const SmallNewick& lhs, const SmallNewick& rhs) noexcept;
+
+///GetCanonicalNewick returns the Newick with the children of each node sorted,
+///see CanonicalizeNewick. Used by CalculateProbability
+SmallNewick GetCanonicalNewick(const SmallNewick& n);
+
+///GetSimplerBinaryNewicksFrequencyPairs writes the simpler Newicks of a binary
+///(or unary) Newick and their frequencies to newicks, as
+///GetSimplerNewicksFrequencyPairs does, without searching for siblings
+void GetSimplerBinaryNewicksFrequencyPairs(
+  const SmallNewick& n,
+  std::vector<std::pair<SmallNewick, int>>& newicks
+);
+
+///GetNewickHash returns the same hash as GetNewickHash on the Newick
+///std::vector<int>, so that a SmallNewick can be a key of NewickHashStorage.
+///Takes constant time, as the hash is kept
+std::uint64_t GetNewickHash(const SmallNewick& n) noexcept;
+
+///GetSimplerNewicksFrequencyPairs creates simpler, derived Newicks from a Newick.
+///Its simpler Newicks and frequencies are identical to those created by
+///GetSimplerNewicksFrequencyPairs on the Newick std::vector<int>.
+///A simpler Newick of at most SmallNewick::inline_capacity elements
+///is created without a heap allocation. The hash of each simpler Newick
+///is derived from the hash of n and the edit in constant time
+std::vector<std::pair<SmallNewick, int>>
+  GetSimplerNewicksFrequencyPairs(const SmallNewick& n);
+
+///GetSimplerNewicksFrequencyPairs writes the simpler Newicks and their
+///frequencies to newicks, reusing its capacity. Does not allocate memory
+///if newicks is big enough and the simpler Newicks are at most
+///SmallNewick::inline_capacity elements
+void GetSimplerNewicksFrequencyPairs(
+  const SmallNewick& n,
+  std::vector<std::pair<SmallNewick, int>>& newicks
+);
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // SMALLNEWICK_H
@@ -0,0 +1,243 @@
+#include "smallnewick.h"
+
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickhash.h"
+#include "newickstorage.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+namespace {
+
+///The probability of a Newick, calculated on std::vector<int>s
+///in the same way as CalculateProbability, without storage
+double CalculateProbabilityOfVector(const std::vector<int>& v, const double theta)
+{
+  if (IsSimple(v)) return CalcProbabilitySimpleNewick(v, theta);
+  const double d = CalcDenominator(v, theta);
+  double p = 0.0;
+  for (const auto& q: GetSimplerNewicksFrequencyPairs(v))
+  {
+    const double f = static_cast<double>(q.second);
+    const double coefficient = q.second == 1 ? theta / d : (f * (f - 1.0)) / d;
+    p += coefficient * CalculateProbabilityOfVector(q.first, theta);
+  }
+  return p;
+}
+
+} //~namespace
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SmallNewick)
+{
+  const std::vector<int> v{StringToNewick("((1,2),3)")};
+  const SmallNewick n(v);
+  BOOST_CHECK(n.ToVector() == v);
+  BOOST_CHECK_EQUAL(n.Size(), v.size());
+  BOOST_CHECK(!n.IsHeapAllocated());
+  BOOST_CHECK(!n.IsSimple());
+  BOOST_CHECK_EQUAL(n.CalcDenominator(10.0), CalcDenominator(v, 10.0));
+  BOOST_CHECK(SmallNewick(StringToNewick("(1,2)")).IsSimple());
+  BOOST_CHECK(n == SmallNewick(v));
+  BOOST_CHECK(n != SmallNewick(StringToNewick("((1,2),4)")));
+  BOOST_CHECK(n < SmallNewick(StringToNewick("((1,2),4)")));
+
+  const std::vector<int> w{StringToNewick(CreateRandomNewick(20, 100))};
+  BOOST_CHECK(SmallNewick(w).IsHeapAllocated());
+  BOOST_CHECK(SmallNewick(w).ToVector() == w);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SmallNewick_GetSimplerNewicksFrequencyPairs)
+{
+  std::vector<std::string> newicks{CreateValidNewicks()};
+  for (int i=2; i!=30; ++i)
+  {
+    newicks.push_back(CreateRandomNewick(i, 3));
+  }
+  for (const std::string& s: newicks)
+  {
+    const std::vector<int> v{StringToNewick(s)};
+    const auto expected = GetSimplerNewicksFrequencyPairs(v);
+    const auto simpler = GetSimplerNewicksFrequencyPairs(SmallNewick(v));
+    BOOST_REQUIRE_EQUAL(simpler.size(), expected.size());
+    for (std::size_t i=0; i!=simpler.size(); ++i)
+    {
+      BOOST_CHECK(simpler[i].first.ToVector() == expected[i].first);
+      BOOST_CHECK_EQUAL(simpler[i].second, expected[i].second);
+      BOOST_CHECK_EQUAL(GetNewickHash(simpler[i].first), GetNewickHash(expected[i].first));
+      BOOST_CHECK_EQUAL(
+        simpler[i].first.IsHeapAllocated(),
+        simpler[i].first.Size() > SmallNewick::inline_capacity
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SmallNewick_CalculateProbability)
+{
+  for (const std::string s: { "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    const double p = CalculateProbability(n, 10.0, storage);
+    BOOST_CHECK_CLOSE(p, CalculateProbabilityOfVector(StringToNewick(s), 10.0), 0.0001);
+    BOOST_CHECK(storage.CountNewicks() > 0);
+    for (const auto& m: storage.Peek())
+    {
+      for (const auto& q: m) BOOST_CHECK(GetCanonicalNewick(q.first) == q.first);
+    }
+  }
+  //Isomorphic Newicks share their stored Newicks
+  const SmallNewick n(StringToNewick("((2,1),(1,2,3))"));
+  ribi::NewickStorage<SmallNewick> storage(n);
+  const double p = CalculateProbability(n, 10.0, storage);
+  const int n_newicks = storage.CountNewicks();
+  BOOST_CHECK_EQUAL(
+    CalculateProbability(SmallNewick(StringToNewick("((3,1,2),(1,2))")), 10.0, storage), p
+  );
+  BOOST_CHECK_EQUAL(storage.CountNewicks(), n_newicks);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SmallNewick_GetSimplerBinaryNewicksFrequencyPairs)
+{
+  std::vector<std::vector<int>> newicks;
+  for (const std::string& s: CreateValidBinaryNewicks())
+  {
+    newicks.push_back(StringToNewick(s));
+  }
+  for (int i=2; i!=30; ++i)
+  {
+    newicks.push_back(CreateRandomBinaryNewickVector(i, 4));
+  }
+  std::vector<std::pair<SmallNewick, int>> simpler;
+  for (const std::vector<int>& v: newicks)
+  {
+    const SmallNewick n(v);
+    BOOST_CHECK(IsBinaryNewick(n));
+    BOOST_CHECK(!IsUnaryNewick(n));
+    GetSimplerBinaryNewicksFrequencyPairs(n, simpler);
+    const auto expected = GetSimplerNewicksFrequencyPairs(v);
+    BOOST_REQUIRE_EQUAL(simpler.size(), expected.size());
+    for (std::size_t i=0; i!=simpler.size(); ++i)
+    {
+      BOOST_CHECK(simpler[i].first.ToVector() == expected[i].first);
+      BOOST_CHECK_EQUAL(simpler[i].second, expected[i].second);
+      BOOST_CHECK_EQUAL(GetNewickHash(simpler[i].first), GetNewickHash(expected[i].first));
+    }
+  }
+  BOOST_CHECK(IsUnaryNewick(SmallNewick(StringToNewick("(3)"))));
+  BOOST_CHECK(!IsBinaryNewick(SmallNewick(StringToNewick("(1,2,3)"))));
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CalculateProbabilityByArity)
+{
+  for (const std::string s: { "(3)", "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    ribi::NewickStorage<SmallNewick> general_storage(n);
+    const double p = CalculateProbability(n, 10.0, storage);
+    BOOST_CHECK_CLOSE(p, CalculateProbabilityOfVector(StringToNewick(s), 10.0), 0.0001);
+    BOOST_CHECK_EQUAL(
+      CalculateProbabilityByArity<GeneralArityPolicy>(n, 10.0, general_storage), p
+    );
+    if (IsBinaryNewick(n))
+    {
+      ribi::NewickStorage<SmallNewick> binary_storage(n);
+      BOOST_CHECK_EQUAL(
+        CalculateProbabilityByArity<BinaryArityPolicy>(n, 10.0, binary_storage), p
+      );
+    }
+  }
+  //Newicks with a binary and a trinary node are not binary
+  for (const std::string s: { "((1,2,1),(1,2))", "((1,2,3),(4,5))", "((4,5),(1,2,3))", "((1,2),(1,(1,2,1)))" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    BOOST_CHECK(!IsBinaryNewick(n));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    ribi::NewickStorage<SmallNewick> general_storage(n);
+    BOOST_CHECK_EQUAL(
+      CalculateProbability(n, 10.0, storage),
+      CalculateProbabilityByArity<GeneralArityPolicy>(n, 10.0, general_storage)
+    );
+  }
+  const SmallNewick n(StringToNewick("((1,2,1),(1,2))"));
+  ribi::NewickStorage<SmallNewick> storage(n);
+  BOOST_CHECK_CLOSE(
+    CalculateProbability(n, 10.0, storage),
+    CalculateProbabilityOfVector(StringToNewick("((1,2,1),(1,2))"), 10.0),
+    0.0001
+  );
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CalculateProbabilityByLevels)
+{
+  for (const std::string s: { "(3)", "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> storage(n);
+    const double p = CalculateProbability(n, 10.0, storage);
+    BOOST_CHECK_CLOSE(CalculateProbabilityByLevels(n, 10.0), p, 0.0001);
+    BOOST_CHECK_CLOSE(
+      (CalculateProbabilityByLevels<SmallNewick, std::unordered_map<SmallNewick,double,NewickHash>>(n, 10.0)),
+      p,
+      0.0001
+    );
+  }
+  //Only the Newicks of two sums of frequencies are kept
+  const SmallNewick n(StringToNewick("((100,10),10)"));
+  ribi::NewickHashStorage<SmallNewick> storage(n);
+  const double p = CalculateProbability(n, 10.0, storage);
+  int max_n_newicks = 0;
+  BOOST_CHECK_CLOSE(CalculateProbabilityByLevels(n, 10.0, max_n_newicks), p, 0.0001);
+  BOOST_CHECK(max_n_newicks > 0);
+  BOOST_CHECK(max_n_newicks * 10 < storage.CountNewicks());
+
+  //Newicks of mixed arity use the general kernel
+  for (const std::string s: { "((1,2,3),(4,5))", "((4,5),(1,2,3))", "((1,2),(1,(1,2,1)))" })
+  {
+    const SmallNewick m(StringToNewick(s));
+    ribi::NewickStorage<SmallNewick> general_storage(m);
+    BOOST_CHECK_CLOSE(
+      CalculateProbabilityByLevels(m, 10.0),
+      CalculateProbabilityByArity<GeneralArityPolicy>(m, 10.0, general_storage),
+      0.0001
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_CalculateProbabilities)
+{
+  const std::vector<double> thetas{0.1, 1.0, 2.5, 10.0, 100.0};
+  for (const std::string s: { "(3)", "(1,2)", "((1,1),1)", "((2,1),3)", "((1,2),(3,1))", "(2,(1,1,3))", "((20,2),3)" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    const std::vector<double> ps = CalculateProbabilities(n, thetas);
+    BOOST_REQUIRE_EQUAL(ps.size(), thetas.size());
+    for (std::size_t i=0; i!=thetas.size(); ++i)
+    {
+      ribi::NewickStorage<SmallNewick> storage(n);
+      BOOST_CHECK_CLOSE(ps[i], CalculateProbability(n, thetas[i], storage), 0.0001);
+    }
+    const auto hash_ps = CalculateProbabilities<SmallNewick, std::unordered_map<SmallNewick,int,NewickHash>>(n, thetas);
+    BOOST_REQUIRE_EQUAL(hash_ps.size(), ps.size());
+    for (std::size_t i=0; i!=ps.size(); ++i) BOOST_CHECK_CLOSE(hash_ps[i], ps[i], 0.0001);
+    BOOST_CHECK(CalculateProbabilities(n, {}).empty());
+  }
+  //Newicks of mixed arity use the general kernel in each lane
+  for (const std::string s: { "((1,2,3),(4,5))", "((4,5),(1,2,3))", "((1,2),(1,(1,2,1)))" })
+  {
+    const SmallNewick n(StringToNewick(s));
+    const std::vector<double> ps = CalculateProbabilities(n, thetas);
+    BOOST_REQUIRE_EQUAL(ps.size(), thetas.size());
+    for (std::size_t i=0; i!=thetas.size(); ++i)
+    {
+      ribi::NewickStorage<SmallNewick> storage(n);
+      BOOST_CHECK_CLOSE(
+        ps[i], CalculateProbabilityByArity<GeneralArityPolicy>(n, thetas[i], storage), 0.0001
+      );
+    }
+  }
+}
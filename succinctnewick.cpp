@@ -0,0 +1,474 @@
+#include "succinctnewick.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <climits>
+#include <iterator>
+
+#include "newick.h"
+
+namespace {
+
+///The number of bits per block, which have their number of ones,
+///number of frequencies and lowest excess stored
+const std::size_t bits_per_block = 256;
+
+///The number of bits of a word
+const std::size_t bits_per_word = 64;
+
+int CountOnes(const std::uint64_t w) noexcept
+{
+  return static_cast<int>(std::bitset<64>(w).count());
+}
+
+///The first block from 'from' on with a lowest excess of at most target,
+///npos if there is none
+std::size_t FindFirstBlock(
+  const std::vector<int>& tree,
+  const std::size_t tree_size,
+  const std::size_t from,
+  const int target
+) noexcept
+{
+  if (from >= tree_size) return ribi::newick::SuccinctNewick::npos;
+  std::size_t node = from + tree_size;
+  if (tree[node] > target)
+  {
+    //Go up until there is a right sibling with a low enough excess
+    while (1)
+    {
+      if (node == 1) return ribi::newick::SuccinctNewick::npos;
+      if (node % 2 == 0 && tree[node + 1] <= target) { ++node; break; }
+      node /= 2;
+    }
+  }
+  //Go down to the leftmost block with a low enough excess
+  while (node < tree_size)
+  {
+    node = tree[2 * node] <= target ? 2 * node : 2 * node + 1;
+  }
+  return node - tree_size;
+}
+
+///The last block up to and including 'to' with a lowest excess
+///of at most target, npos if there is none
+std::size_t FindLastBlock(
+  const std::vector<int>& tree,
+  const std::size_t tree_size,
+  const std::size_t to,
+  const int target
+) noexcept
+{
+  assert(to < tree_size);
+  std::size_t node = to + tree_size;
+  if (tree[node] > target)
+  {
+    //Go up until there is a left sibling with a low enough excess
+    while (1)
+    {
+      if (node == 1) return ribi::newick::SuccinctNewick::npos;
+      if (node % 2 == 1 && tree[node - 1] <= target) { --node; break; }
+      node /= 2;
+    }
+  }
+  //Go down to the rightmost block with a low enough excess
+  while (node < tree_size)
+  {
+    node = tree[2 * node + 1] <= target ? 2 * node + 1 : 2 * node;
+  }
+  return node - tree_size;
+}
+
+///Append a bit to the words of a bitvector of n_bits bits
+void PushBit(std::vector<std::uint64_t>& bits, std::size_t& n_bits, const bool bit)
+{
+  if (n_bits % bits_per_word == 0) bits.push_back(0);
+  if (bit) bits.back() |= std::uint64_t(1) << (n_bits % bits_per_word);
+  ++n_bits;
+}
+
+///Convert a Newick to its balanced parentheses and their number
+std::pair<std::vector<std::uint64_t>, std::size_t> CreateBalancedParentheses(
+  const std::vector<int>& v
+)
+{
+  std::vector<std::uint64_t> bits;
+  std::size_t n_bits = 0;
+  for (const int x: v)
+  {
+    if (x == ribi::newick::bracket_open) { PushBit(bits, n_bits, true); }
+    else if (x == ribi::newick::bracket_close) { PushBit(bits, n_bits, false); }
+    else { PushBit(bits, n_bits, true); PushBit(bits, n_bits, false); }
+  }
+  return std::make_pair(bits, n_bits);
+}
+
+///Get the frequencies of a Newick, in order
+std::vector<int> GetFrequencies(const std::vector<int>& v)
+{
+  std::vector<int> frequencies;
+  std::copy_if(
+    std::begin(v), std::end(v), std::back_inserter(frequencies),
+    [](const int x) { return x > 0; }
+  );
+  return frequencies;
+}
+
+} //~namespace
+
+ribi::newick::SuccinctNewick::SuccinctNewick(const std::vector<int>& v)
+  : SuccinctNewick(CreateBalancedParentheses(v), GetFrequencies(v))
+{
+  assert(IsNewick(v));
+}
+
+ribi::newick::SuccinctNewick::SuccinctNewick(
+  const std::pair<std::vector<std::uint64_t>, std::size_t>& bits,
+  const std::vector<int>& frequencies
+)
+  : m_bits{bits.first},
+    m_block_ones{},
+    m_block_frequencies{},
+    m_block_min_excess{},
+    m_frequencies{},
+    m_frequency_width{1},
+    m_n_bits{bits.second},
+    m_n_frequencies{frequencies.size()},
+    m_tree_size{1}
+{
+  assert(m_n_bits % 2 == 0);
+  assert(m_bits.size() == (m_n_bits + bits_per_word - 1) / bits_per_word);
+
+  //Pack the frequencies
+  const int max = frequencies.empty()
+    ? 1 : *std::max_element(std::begin(frequencies), std::end(frequencies));
+  assert(max > 0);
+  while (m_frequency_width < 31 && (max >> m_frequency_width) != 0) ++m_frequency_width;
+  m_frequencies.resize((m_n_frequencies * m_frequency_width + bits_per_word - 1) / bits_per_word);
+  for (std::size_t k=0; k!=m_n_frequencies; ++k)
+  {
+    const std::uint64_t f = static_cast<std::uint64_t>(frequencies[k]);
+    const std::size_t pos = k * m_frequency_width;
+    m_frequencies[pos / bits_per_word] |= f << (pos % bits_per_word);
+    if (pos % bits_per_word + m_frequency_width > bits_per_word)
+    {
+      m_frequencies[pos / bits_per_word + 1] |= f >> (bits_per_word - pos % bits_per_word);
+    }
+  }
+
+  //Set the number of ones and frequencies before each block,
+  //and the lowest excess in each block
+  const std::size_t n_blocks = (m_n_bits + bits_per_block - 1) / bits_per_block;
+  while (m_tree_size < n_blocks) m_tree_size *= 2;
+  m_block_ones.resize(n_blocks + 1, 0);
+  m_block_frequencies.resize(n_blocks + 1, 0);
+  m_block_min_excess.resize(2 * m_tree_size, INT_MAX);
+  int excess = 0;
+  std::size_t n_ones = 0;
+  std::size_t n_frequencies = 0;
+  for (std::size_t block=0; block!=n_blocks; ++block)
+  {
+    m_block_ones[block] = static_cast<std::uint32_t>(n_ones);
+    m_block_frequencies[block] = static_cast<std::uint32_t>(n_frequencies);
+    int min_excess = INT_MAX;
+    const std::size_t end = std::min(m_n_bits, (block + 1) * bits_per_block);
+    for (std::size_t i = block * bits_per_block; i!=end; ++i)
+    {
+      const bool bit = GetBit(i);
+      if (bit)
+      {
+        ++n_ones;
+        if (!GetBit(i + 1)) ++n_frequencies;
+      }
+      excess += bit ? 1 : -1;
+      min_excess = std::min(min_excess, excess);
+    }
+    m_block_min_excess[m_tree_size + block] = min_excess;
+  }
+  m_block_ones[n_blocks] = static_cast<std::uint32_t>(n_ones);
+  m_block_frequencies[n_blocks] = static_cast<std::uint32_t>(n_frequencies);
+  assert(excess == 0);
+  assert(n_frequencies == m_n_frequencies);
+  for (std::size_t node = m_tree_size - 1; node != 0; --node)
+  {
+    m_block_min_excess[node] = std::min(
+      m_block_min_excess[2 * node],
+      m_block_min_excess[2 * node + 1]
+    );
+  }
+}
+
+bool ribi::newick::SuccinctNewick::GetBit(const std::size_t i) const noexcept
+{
+  if (i >= m_n_bits) return false;
+  return (m_bits[i / bits_per_word] >> (i % bits_per_word)) & 1;
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetClose(const std::size_t i) const noexcept
+{
+  assert(GetBit(i));
+  return SearchForward(i, GetExcess(i) - 1);
+}
+
+int ribi::newick::SuccinctNewick::GetDepth(const std::size_t i) const noexcept
+{
+  assert(GetBit(i));
+  return GetExcess(i) - 1;
+}
+
+int ribi::newick::SuccinctNewick::GetExcess(const std::size_t i) const noexcept
+{
+  assert(i < m_n_bits);
+  return 2 * static_cast<int>(Rank(i + 1)) - static_cast<int>(i + 1);
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetFirstChild(const std::size_t i) const noexcept
+{
+  assert(GetBit(i));
+  return IsFrequency(i) ? npos : i + 1;
+}
+
+int ribi::newick::SuccinctNewick::GetFrequency(const std::size_t i) const noexcept
+{
+  assert(IsFrequency(i));
+  const std::size_t pos = RankFrequencies(i) * m_frequency_width;
+  std::uint64_t f = m_frequencies[pos / bits_per_word] >> (pos % bits_per_word);
+  if (pos % bits_per_word + m_frequency_width > bits_per_word)
+  {
+    f |= m_frequencies[pos / bits_per_word + 1] << (bits_per_word - pos % bits_per_word);
+  }
+  return static_cast<int>(f & ((std::uint64_t(1) << m_frequency_width) - 1));
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetMemoryUse() const noexcept
+{
+  return sizeof(*this)
+    + m_bits.capacity() * sizeof(std::uint64_t)
+    + m_block_ones.capacity() * sizeof(std::uint32_t)
+    + m_block_frequencies.capacity() * sizeof(std::uint32_t)
+    + m_block_min_excess.capacity() * sizeof(int)
+    + m_frequencies.capacity() * sizeof(std::uint64_t);
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetNextSibling(const std::size_t i) const noexcept
+{
+  const std::size_t j = GetClose(i) + 1;
+  return GetBit(j) ? j : npos;
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetParent(const std::size_t i) const noexcept
+{
+  assert(GetBit(i));
+  if (i == 0) return npos;
+  return SearchBackward(i, GetExcess(i) - 2);
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetPreviousSibling(const std::size_t i) const noexcept
+{
+  assert(GetBit(i));
+  if (i == 0 || GetBit(i - 1)) return npos;
+  //The node closed at i - 1
+  return SearchBackward(i - 1, GetExcess(i - 1));
+}
+
+std::size_t ribi::newick::SuccinctNewick::GetSubtreeSize(const std::size_t i) const noexcept
+{
+  return (GetClose(i) - i + 1) / 2;
+}
+
+bool ribi::newick::SuccinctNewick::IsFrequency(const std::size_t i) const noexcept
+{
+  assert(GetBit(i));
+  return !GetBit(i + 1);
+}
+
+std::size_t ribi::newick::SuccinctNewick::Rank(const std::size_t i) const noexcept
+{
+  assert(i <= m_n_bits);
+  const std::size_t block = i / bits_per_block;
+  std::size_t n = m_block_ones[block];
+  for (std::size_t w = block * bits_per_block / bits_per_word; w != i / bits_per_word; ++w)
+  {
+    n += CountOnes(m_bits[w]);
+  }
+  if (i % bits_per_word != 0)
+  {
+    n += CountOnes(
+      m_bits[i / bits_per_word] & ((std::uint64_t(1) << (i % bits_per_word)) - 1)
+    );
+  }
+  return n;
+}
+
+std::size_t ribi::newick::SuccinctNewick::RankFrequencies(const std::size_t i) const noexcept
+{
+  assert(i <= m_n_bits);
+  //A frequency starts at each one that is followed by a zero
+  const auto get_starts = [this](const std::size_t w)
+  {
+    const std::uint64_t next = w + 1 < m_bits.size() ? m_bits[w + 1] : 0;
+    return m_bits[w] & ~((m_bits[w] >> 1) | (next << (bits_per_word - 1)));
+  };
+  const std::size_t block = i / bits_per_block;
+  std::size_t n = m_block_frequencies[block];
+  for (std::size_t w = block * bits_per_block / bits_per_word; w != i / bits_per_word; ++w)
+  {
+    n += CountOnes(get_starts(w));
+  }
+  if (i % bits_per_word != 0)
+  {
+    n += CountOnes(
+      get_starts(i / bits_per_word) & ((std::uint64_t(1) << (i % bits_per_word)) - 1)
+    );
+  }
+  return n;
+}
+
+std::size_t ribi::newick::SuccinctNewick::SearchBackward(
+  const std::size_t i,
+  const int target
+) const noexcept
+{
+  //The virtual bit -1 has an excess of zero
+  const std::size_t none = target >= 0 ? 0 : npos;
+  if (i == 0) return none;
+  std::size_t j = i - 1;
+  int excess = GetExcess(j);
+  //Search the rest of the block of j
+  std::size_t block_begin = j / bits_per_block * bits_per_block;
+  while (1)
+  {
+    if (excess <= target) return j + 1;
+    if (j == block_begin) break;
+    excess -= GetBit(j) ? 1 : -1;
+    --j;
+  }
+  //Search the last block before that with a low enough excess
+  if (block_begin == 0) return none;
+  const std::size_t block = FindLastBlock(
+    m_block_min_excess, m_tree_size, block_begin / bits_per_block - 1, target
+  );
+  if (block == npos) return none;
+  j = (block + 1) * bits_per_block - 1;
+  block_begin = block * bits_per_block;
+  excess = GetExcess(j);
+  while (1)
+  {
+    if (excess <= target) return j + 1;
+    assert(j != block_begin);
+    excess -= GetBit(j) ? 1 : -1;
+    --j;
+  }
+}
+
+std::size_t ribi::newick::SuccinctNewick::SearchForward(
+  const std::size_t i,
+  const int target
+) const noexcept
+{
+  //Search the rest of the block of i
+  const std::size_t block_end = std::min(m_n_bits, (i / bits_per_block + 1) * bits_per_block);
+  int excess = GetExcess(i);
+  for (std::size_t j = i + 1; j < block_end; ++j)
+  {
+    excess += GetBit(j) ? 1 : -1;
+    if (excess <= target) return j;
+  }
+  //Search the first block after that with a low enough excess
+  const std::size_t block = FindFirstBlock(
+    m_block_min_excess, m_tree_size, i / bits_per_block + 1, target
+  );
+  if (block == npos) return npos;
+  const std::size_t begin = block * bits_per_block;
+  const std::size_t end = std::min(m_n_bits, begin + bits_per_block);
+  excess = GetExcess(begin - 1);
+  for (std::size_t j = begin; j != end; ++j)
+  {
+    excess += GetBit(j) ? 1 : -1;
+    if (excess <= target) return j;
+  }
+  assert(!"Should not get here"); //!OCLINT accepted idiom
+  return npos;
+}
+
+std::vector<int> ribi::newick::SuccinctNewick::ToVector() const
+{
+  std::vector<int> v;
+  v.reserve(m_n_bits - m_n_frequencies);
+  for (std::size_t i=0; i!=m_n_bits; ++i)
+  {
+    if (!GetBit(i)) { v.push_back(bracket_close); }
+    else if (IsFrequency(i)) { v.push_back(GetFrequency(i)); ++i; }
+    else { v.push_back(bracket_open); }
+  }
+  return v;
+}
+
+std::vector<int> ribi::newick::GetDepth(const SuccinctNewick& n)
+{
+  //Unlike SuccinctNewick::GetDepth, a frequency has the depth of its parent
+  std::vector<int> v;
+  v.reserve(n.m_n_bits - n.m_n_frequencies);
+  int depth = -1;
+  for (std::size_t i=0; i!=n.m_n_bits; ++i)
+  {
+    if (!n.GetBit(i)) { v.push_back(depth); --depth; }
+    else if (!n.GetBit(i + 1)) { v.push_back(depth); ++i; }
+    else { ++depth; v.push_back(depth); }
+  }
+  return v;
+}
+
+std::vector<ribi::newick::SuccinctNewick> ribi::newick::GetRootBranches(
+  const SuccinctNewick& n)
+{
+  assert(n.GetFirstChild(n.GetRoot()) != SuccinctNewick::npos);
+  std::vector<SuccinctNewick> v;
+  for (std::size_t i = n.GetFirstChild(n.GetRoot());
+    i != SuccinctNewick::npos;
+    i = n.GetNextSibling(i))
+  {
+    std::vector<std::uint64_t> bits;
+    std::size_t n_bits = 0;
+    std::vector<int> frequencies;
+    if (n.IsFrequency(i))
+    {
+      //A frequency f becomes the Newick '(f)'
+      for (const bool bit: { true, true, false, false }) PushBit(bits, n_bits, bit);
+      frequencies.push_back(n.GetFrequency(i));
+    }
+    else
+    {
+      const std::size_t close = n.GetClose(i);
+      for (std::size_t j = i; j != close + 1; ++j)
+      {
+        const bool bit = n.GetBit(j);
+        PushBit(bits, n_bits, bit);
+        if (bit && n.IsFrequency(j)) frequencies.push_back(n.GetFrequency(j));
+      }
+    }
+    v.push_back(SuccinctNewick(std::make_pair(bits, n_bits), frequencies));
+  }
+  assert(v.size() > 1);
+  return v;
+}
+
+bool ribi::newick::IsBinaryNewick(const SuccinctNewick& n)
+{
+  //The number of children of each node that is not closed yet
+  std::vector<int> n_children;
+  for (std::size_t i=0; i!=n.m_n_bits; ++i)
+  {
+    if (!n.GetBit(i))
+    {
+      if (n_children.back() != 2) return false;
+      n_children.pop_back();
+      continue;
+    }
+    if (!n_children.empty()) ++n_children.back();
+    if (n.GetBit(i + 1)) { n_children.push_back(0); }
+    else { ++i; } //A frequency
+  }
+  return true;
+}
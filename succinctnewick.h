@@ -0,0 +1,140 @@
+#ifndef SUCCINCTNEWICK_H
+#define SUCCINCTNEWICK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ribi {
+namespace newick {
+
+///SuccinctNewick stores a Newick as a balanced-parentheses bitvector,
+///in which each node is a one bit, followed by the bits of its children,
+///followed by a zero bit. A frequency is a node without children.
+///The frequencies are stored in a packed array, using as many bits
+///per frequency as the highest frequency needs.
+///
+///A node is identified by the index of its one bit, the root being 0.
+///Navigating the tree takes O(log n) time, using the number of ones
+///and the lowest excess (ones minus zeroes) per block of bits.
+///For example, '((1,2),3)' is stored as 1 1 10 10 0 10 0,
+///with frequencies { 1, 2, 3 }
+struct SuccinctNewick
+{
+  ///Converts a valid Newick std::vector<int>
+  explicit SuccinctNewick(const std::vector<int>& v);
+
+  ///Used for the absence of a node
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  ///The depth of node i, which is zero for the root
+  int GetDepth(const std::size_t i) const noexcept;
+
+  ///The first child of node i, npos if node i is a frequency
+  std::size_t GetFirstChild(const std::size_t i) const noexcept;
+
+  ///The frequency of node i, which must be a frequency
+  int GetFrequency(const std::size_t i) const noexcept;
+
+  ///The index of the zero bit that closes node i
+  std::size_t GetClose(const std::size_t i) const noexcept;
+
+  ///The number of bytes used
+  std::size_t GetMemoryUse() const noexcept;
+
+  ///The next sibling of node i, npos if there is none
+  std::size_t GetNextSibling(const std::size_t i) const noexcept;
+
+  ///The number of frequencies
+  std::size_t GetNumberOfFrequencies() const noexcept { return m_n_frequencies; }
+
+  ///The number of nodes, including the root
+  std::size_t GetNumberOfNodes() const noexcept { return m_n_bits / 2; }
+
+  ///The parent of node i, npos for the root
+  std::size_t GetParent(const std::size_t i) const noexcept;
+
+  ///The previous sibling of node i, npos if there is none
+  std::size_t GetPreviousSibling(const std::size_t i) const noexcept;
+
+  ///The node that is the root
+  std::size_t GetRoot() const noexcept { return 0; }
+
+  ///The number of nodes in the subtree of node i, including node i
+  std::size_t GetSubtreeSize(const std::size_t i) const noexcept;
+
+  ///Is node i a frequency?
+  bool IsFrequency(const std::size_t i) const noexcept;
+
+  ///Converts back to a Newick std::vector<int>
+  std::vector<int> ToVector() const;
+
+  private:
+  ///Creates a SuccinctNewick from its parts
+  SuccinctNewick(
+    const std::pair<std::vector<std::uint64_t>, std::size_t>& bits,
+    const std::vector<int>& frequencies
+  );
+
+  ///The balanced parentheses, 64 per word, the first in the lowest bit
+  std::vector<std::uint64_t> m_bits;
+
+  ///The number of ones before each block
+  std::vector<std::uint32_t> m_block_ones;
+
+  ///The number of frequencies before each block
+  std::vector<std::uint32_t> m_block_frequencies;
+
+  ///The lowest excess in each block, as a segment tree,
+  ///in which the block minima start at index m_tree_size
+  std::vector<int> m_block_min_excess;
+
+  ///The frequencies, m_frequency_width bits each
+  std::vector<std::uint64_t> m_frequencies;
+
+  int m_frequency_width;
+  std::size_t m_n_bits;
+  std::size_t m_n_frequencies;
+  std::size_t m_tree_size;
+
+  ///Get bit i
+  bool GetBit(const std::size_t i) const noexcept;
+
+  ///The excess (ones minus zeroes) of the bits from 0 to and including i
+  int GetExcess(const std::size_t i) const noexcept;
+
+  ///The smallest j > i with GetExcess(j) <= target, npos if there is none
+  std::size_t SearchForward(const std::size_t i, const int target) const noexcept;
+
+  ///The largest j < i with GetExcess(j) <= target, plus one.
+  ///Returns 0 if this j is the virtual bit -1 with excess zero,
+  ///npos if there is none
+  std::size_t SearchBackward(const std::size_t i, const int target) const noexcept;
+
+  ///The number of ones in the bits before i
+  std::size_t Rank(const std::size_t i) const noexcept;
+
+  ///The number of frequencies that start before bit i
+  std::size_t RankFrequencies(const std::size_t i) const noexcept;
+
+  friend std::vector<int> GetDepth(const SuccinctNewick& n);
+  friend std::vector<SuccinctNewick> GetRootBranches(const SuccinctNewick& n);
+  friend bool IsBinaryNewick(const SuccinctNewick& n);
+};
+
+///GetDepth returns the same as GetDepth on the Newick std::vector<int>
+std::vector<int> GetDepth(const SuccinctNewick& n);
+
+///GetRootBranches returns the same as GetRootBranches on the
+///Newick std::vector<int>, without converting to it
+std::vector<SuccinctNewick> GetRootBranches(const SuccinctNewick& n);
+
+///IsBinaryNewick returns true if each node that is not a frequency
+///has exactly two children
+bool IsBinaryNewick(const SuccinctNewick& n);
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // SUCCINCTNEWICK_H
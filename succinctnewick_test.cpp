@@ -0,0 +1,145 @@
+#include "succinctnewick.h"
+
+#include <string>
+#include <vector>
+
+#include "newick.h"
+#include "newickindex.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+namespace {
+
+///All valid Newicks used in testing, as std::vector<int>,
+///among which Newicks that span multiple blocks of bits
+std::vector<std::vector<int>> CreateSuccinctNewickTestNewicks()
+{
+  std::vector<std::vector<int>> v;
+  for (const std::string& s: CreateValidNewicks())
+  {
+    v.push_back(StringToNewick(s));
+  }
+  for (int i=2; i!=50; ++i)
+  {
+    v.push_back(StringToNewick(CreateRandomNewick(i, 3)));
+  }
+  for (const int i: { 100, 200, 500, 1000 })
+  {
+    v.push_back(StringToNewick(CreateRandomNewick(i, 1000)));
+  }
+  return v;
+}
+
+} //~namespace
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SuccinctNewick)
+{
+  // ((1,2),3) is stored as 1 1 10 10 0 10 0
+  //                        0 1 23 45 6 78 9
+  const SuccinctNewick n(StringToNewick("((1,2),3)"));
+  BOOST_CHECK_EQUAL(n.GetNumberOfNodes(), 5);
+  BOOST_CHECK_EQUAL(n.GetNumberOfFrequencies(), 3);
+  BOOST_CHECK_EQUAL(n.GetRoot(), 0);
+  BOOST_CHECK_EQUAL(n.GetClose(0), 9);
+  BOOST_CHECK_EQUAL(n.GetClose(1), 6);
+  BOOST_CHECK_EQUAL(n.GetFirstChild(0), 1);
+  BOOST_CHECK_EQUAL(n.GetFirstChild(1), 2);
+  BOOST_CHECK_EQUAL(n.GetFirstChild(2), SuccinctNewick::npos);
+  BOOST_CHECK_EQUAL(n.GetNextSibling(1), 7);
+  BOOST_CHECK_EQUAL(n.GetNextSibling(2), 4);
+  BOOST_CHECK_EQUAL(n.GetNextSibling(4), SuccinctNewick::npos);
+  BOOST_CHECK_EQUAL(n.GetPreviousSibling(7), 1);
+  BOOST_CHECK_EQUAL(n.GetPreviousSibling(2), SuccinctNewick::npos);
+  BOOST_CHECK_EQUAL(n.GetParent(0), SuccinctNewick::npos);
+  BOOST_CHECK_EQUAL(n.GetParent(4), 1);
+  BOOST_CHECK_EQUAL(n.GetParent(7), 0);
+  BOOST_CHECK_EQUAL(n.GetDepth(4), 2);
+  BOOST_CHECK_EQUAL(n.GetSubtreeSize(0), 5);
+  BOOST_CHECK_EQUAL(n.GetSubtreeSize(1), 3);
+  BOOST_CHECK_EQUAL(n.GetSubtreeSize(7), 1);
+  BOOST_CHECK(!n.IsFrequency(1));
+  BOOST_CHECK(n.IsFrequency(7));
+  BOOST_CHECK_EQUAL(n.GetFrequency(2), 1);
+  BOOST_CHECK_EQUAL(n.GetFrequency(4), 2);
+  BOOST_CHECK_EQUAL(n.GetFrequency(7), 3);
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SuccinctNewick_navigation)
+{
+  for (const std::vector<int>& v: CreateSuccinctNewickTestNewicks())
+  {
+    const SuccinctNewick n(v);
+    BOOST_CHECK(n.ToVector() == v);
+    const NewickIndex index(v);
+    const int sz = v.size();
+    //The bit of each element of v, its one bit if it opens a node
+    std::vector<std::size_t> bits(sz);
+    std::size_t bit = 0;
+    for (int i=0; i!=sz; ++i)
+    {
+      bits[i] = bit;
+      bit += v[i] > 0 ? 2 : 1;
+    }
+    const auto to_bit = [&bits](const std::size_t i)
+    {
+      return i == NewickIndex::npos ? SuccinctNewick::npos : bits[i];
+    };
+    for (int i=0; i!=sz; ++i)
+    {
+      if (v[i] == bracket_close) continue;
+      const std::size_t b = bits[i];
+      BOOST_CHECK_EQUAL(n.GetParent(b), to_bit(index.GetParent(i)));
+      BOOST_CHECK_EQUAL(n.GetNextSibling(b), to_bit(index.GetNextSibling(i)));
+      BOOST_CHECK_EQUAL(n.GetPreviousSibling(b), to_bit(index.GetPreviousSibling(i)));
+      if (v[i] > 0)
+      {
+        BOOST_CHECK(n.IsFrequency(b));
+        BOOST_CHECK_EQUAL(n.GetFrequency(b), v[i]);
+        BOOST_CHECK_EQUAL(n.GetSubtreeSize(b), 1);
+      }
+      else
+      {
+        const std::size_t close = index.GetMatchingBracket(i);
+        BOOST_CHECK_EQUAL(n.GetClose(b), bits[close]);
+        BOOST_CHECK_EQUAL(n.GetDepth(b), index.GetDepths()[i]);
+        BOOST_CHECK_EQUAL(
+          n.GetSubtreeSize(b),
+          (bits[close] - b + 1) / 2
+        );
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_SuccinctNewick_overloads)
+{
+  for (const std::vector<int>& v: CreateSuccinctNewickTestNewicks())
+  {
+    const SuccinctNewick n(v);
+    BOOST_CHECK(GetDepth(n) == GetDepth(v));
+    if (!IsUnaryNewick(v))
+    {
+      const std::vector<std::vector<int>> expected{GetRootBranches(v)};
+      const std::vector<SuccinctNewick> branches{GetRootBranches(n)};
+      BOOST_REQUIRE_EQUAL(branches.size(), expected.size());
+      for (std::size_t i=0; i!=branches.size(); ++i)
+      {
+        BOOST_CHECK(branches[i].ToVector() == expected[i]);
+      }
+    }
+  }
+  for (const std::string& s: CreateValidBinaryNewicks())
+  {
+    BOOST_CHECK(IsBinaryNewick(SuccinctNewick(StringToNewick(s))));
+  }
+  for (const std::string& s: CreateValidTrinaryNewicks())
+  {
+    BOOST_CHECK(!IsBinaryNewick(SuccinctNewick(StringToNewick(s))));
+  }
+  for (const std::string& s: CreateValidUnaryNewicks())
+  {
+    BOOST_CHECK(!IsBinaryNewick(SuccinctNewick(StringToNewick(s))));
+  }
+  BOOST_CHECK(IsBinaryNewick(SuccinctNewick(StringToNewick(CreateRandomNewick(1000, 1000)))));
+}
@@ -0,0 +1,62 @@
+#include "validatednewick.h"
+
+#include <stdexcept>
+#include <utility>
+
+ribi::newick::ValidatedNewick::ValidatedNewick(std::vector<int> v)
+  : m_v{std::move(v)}
+{
+  CheckNewick(m_v);
+}
+
+ribi::newick::ValidatedNewick::ValidatedNewick(const std::string_view s)
+  : m_v{}
+{
+  const NewickError error = ParseNewick(s, m_v);
+  if (error.code != NewickErrorCode::none)
+  {
+    throw std::invalid_argument(GetNewickErrorMessage(error, s));
+  }
+}
+
+ribi::newick::ValidatedNewick::ValidatedNewick(
+  std::vector<int> v,
+  const Unchecked
+) noexcept
+  : m_v{std::move(v)}
+{
+
+}
+
+ribi::newick::NewickError ribi::newick::ParseNewick(
+  const std::string_view s,
+  std::optional<ValidatedNewick>& newick
+)
+{
+  std::vector<int> v;
+  const NewickError error = ParseNewick(s, v);
+  if (error.code == NewickErrorCode::none)
+  {
+    newick = ValidatedNewick(std::move(v), ValidatedNewick::Unchecked());
+  }
+  else
+  {
+    newick.reset();
+  }
+  return error;
+}
+
+bool ribi::newick::operator==(const ValidatedNewick& lhs, const ValidatedNewick& rhs) noexcept
+{
+  return lhs.Peek() == rhs.Peek();
+}
+
+bool ribi::newick::operator!=(const ValidatedNewick& lhs, const ValidatedNewick& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+bool ribi::newick::operator<(const ValidatedNewick& lhs, const ValidatedNewick& rhs) noexcept
+{
+  return lhs.Peek() < rhs.Peek();
+}
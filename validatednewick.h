@@ -0,0 +1,63 @@
+#ifndef VALIDATEDNEWICK_H
+#define VALIDATEDNEWICK_H
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "newick.h"
+
+namespace ribi {
+namespace newick {
+
+///ValidatedNewick is a Newick std::vector<int> that is known to be valid.
+///It can only be created by validating a Newick, or by deriving
+///it from another ValidatedNewick. The functions that take a
+///ValidatedNewick do not check it again, so a Newick is checked
+///once, instead of at every call of a function that uses it
+struct ValidatedNewick
+{
+  ///Checks v with CheckNewick, which throws std::invalid_argument
+  ///if v is not a valid Newick
+  explicit ValidatedNewick(std::vector<int> v);
+
+  ///Converts s with ParseNewick, throws std::invalid_argument
+  ///if s is not a valid Newick or has a frequency that does not fit in an int
+  explicit ValidatedNewick(const std::string_view s);
+
+  const std::vector<int>& Peek() const noexcept { return m_v; }
+
+  private:
+  ///Tag to create a ValidatedNewick without checking it
+  struct Unchecked {};
+
+  ///Only for a v that is valid by construction
+  ValidatedNewick(std::vector<int> v, const Unchecked) noexcept;
+
+  std::vector<int> m_v;
+
+  friend std::vector<ValidatedNewick> GetSimplerNewicks(const ValidatedNewick& n);
+  friend NewickError ParseNewick(
+    const std::string_view s,
+    std::optional<ValidatedNewick>& newick
+  );
+  friend ValidatedNewick ReplaceLeave(const ValidatedNewick& newick, const int value);
+};
+
+///ParseNewick converts a std::string to a ValidatedNewick,
+///without throwing exceptions. If s is a valid Newick, newick
+///is set to it and an error with code NewickErrorCode::none is returned.
+///Else newick is reset and the error of ParseNewick is returned
+NewickError ParseNewick(
+  const std::string_view s,
+  std::optional<ValidatedNewick>& newick
+);
+
+bool operator==(const ValidatedNewick& lhs, const ValidatedNewick& rhs) noexcept;
+bool operator!=(const ValidatedNewick& lhs, const ValidatedNewick& rhs) noexcept;
+bool operator<(const ValidatedNewick& lhs, const ValidatedNewick& rhs) noexcept;
+
+} //~namespace newick
+} //~namespace ribi
+
+#endif // VALIDATEDNEWICK_H
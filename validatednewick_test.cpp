@@ -0,0 +1,76 @@
+#include "validatednewick.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ribi::newick;
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ValidatedNewick_construction)
+{
+  for (const std::string& s: CreateValidNewicks())
+  {
+    const ValidatedNewick n(s);
+    BOOST_CHECK(n.Peek() == StringToNewick(s));
+    BOOST_CHECK(ValidatedNewick(StringToNewick(s)) == n);
+  }
+  for (const std::string& s: CreateInvalidNewicks())
+  {
+    BOOST_CHECK_THROW(ValidatedNewick{s}, std::invalid_argument);
+    std::optional<ValidatedNewick> n{ValidatedNewick("(1,2)")};
+    BOOST_CHECK(ParseNewick(s, n).code != NewickErrorCode::none);
+    BOOST_CHECK(!n);
+  }
+  const std::vector<int> invalid{bracket_open, 0, bracket_close};
+  BOOST_CHECK_THROW(ValidatedNewick{invalid}, std::invalid_argument);
+
+  std::optional<ValidatedNewick> n;
+  BOOST_CHECK(ParseNewick("(1,(2,3))", n).code == NewickErrorCode::none);
+  BOOST_CHECK(n);
+  BOOST_CHECK(n->Peek() == StringToNewick("(1,(2,3))"));
+}
+
+BOOST_AUTO_TEST_CASE(ribi_newick_ValidatedNewick_overloads)
+{
+  for (const std::string& s: CreateValidNewicks())
+  {
+    const std::vector<int> v{StringToNewick(s)};
+    const ValidatedNewick n(v);
+    BOOST_CHECK(GetDepth(n) == GetDepth(v));
+    BOOST_CHECK_EQUAL(GetLeafMaxArity(n), GetLeafMaxArity(v));
+    BOOST_CHECK_EQUAL(IsBinaryNewick(n), IsBinaryNewick(v));
+    BOOST_CHECK_EQUAL(IsTrinaryNewick(n), IsTrinaryNewick(v));
+    BOOST_CHECK_EQUAL(IsUnaryNewick(n), IsUnaryNewick(v));
+    BOOST_CHECK_EQUAL(IsSimple(n), IsSimple(v));
+    if (IsSimple(v))
+    {
+      BOOST_CHECK_EQUAL(
+        CalcProbabilitySimpleNewick(n, 10.0),
+        CalcProbabilitySimpleNewick(v, 10.0)
+      );
+      BOOST_CHECK_THROW(ReplaceLeave(n, 42), std::invalid_argument);
+    }
+    else
+    {
+      BOOST_CHECK(ReplaceLeave(n, 42).Peek() == ReplaceLeave(v, 42));
+      BOOST_CHECK_THROW(ReplaceLeave(n, 0), std::invalid_argument);
+      BOOST_CHECK_THROW(ReplaceLeave(n, -1), std::invalid_argument);
+    }
+    const std::vector<std::vector<int>> expected{GetSimplerNewicks(v)};
+    const std::vector<ValidatedNewick> simpler{GetSimplerNewicks(n)};
+    BOOST_CHECK(
+      std::equal(
+        std::begin(simpler), std::end(simpler),
+        std::begin(expected), std::end(expected),
+        [](const ValidatedNewick& lhs, const std::vector<int>& rhs)
+        {
+          return lhs.Peek() == rhs;
+        }
+      )
+    );
+  }
+}